@@ -0,0 +1,125 @@
+#include <stdlib.h>
+#include <assert.h>
+#include "arena.h"
+
+
+// Heap allocations made through `heap_alloc`/`heap_realloc`, and by SDL once `count_sdl_allocations` is called. Atomic because
+// SDL may allocate from its own threads.
+SDL_atomic_t allocation_count;
+
+SDL_malloc_func sdl_malloc = NULL;
+SDL_calloc_func sdl_calloc = NULL;
+SDL_realloc_func sdl_realloc = NULL;
+SDL_free_func sdl_free = NULL;
+
+
+static void* counting_malloc(size_t size);
+static void* counting_calloc(size_t count, size_t size);
+static void* counting_realloc(void* memory, size_t size);
+
+
+/* Sets up an arena of `size` bytes. */
+void
+new_arena(Arena* arena, size_t size) {
+	arena->base = (Uint8*)heap_alloc(size);
+	arena->size = size;
+	arena->used = 0;
+}
+
+
+/* Frees the block of an arena. */
+void
+free_arena(Arena* arena) {
+	heap_free(arena->base);
+	arena->base = NULL;
+	arena->size = 0;
+	arena->used = 0;
+}
+
+
+/* Returns `size` bytes from `arena`, aligned to `ARENA_ALIGNMENT`. The arena must be large enough. */
+void*
+arena_alloc(Arena* arena, size_t size) {
+
+	void* memory;
+
+	size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+	assert(arena->used + size <= arena->size);
+	memory = arena->base + arena->used;
+	arena->used += size;
+	return memory;
+}
+
+
+/* Releases everything allocated from `arena`. */
+void
+arena_reset(Arena* arena) {
+	arena->used = 0;
+}
+
+
+/* Counted `malloc`. */
+void*
+heap_alloc(size_t size) {
+	void* memory = malloc(size);
+	assert(memory != NULL);
+	SDL_AtomicAdd(&allocation_count, 1);
+	return memory;
+}
+
+
+/* Counted `realloc`. */
+void*
+heap_realloc(void* memory, size_t size) {
+	memory = realloc(memory, size);
+	assert(memory != NULL);
+	SDL_AtomicAdd(&allocation_count, 1);
+	return memory;
+}
+
+
+/* Frees memory from `heap_alloc` or `heap_realloc`. */
+void
+heap_free(void* memory) {
+	free(memory);
+}
+
+
+/* Returns the number of heap allocations counted so far. */
+long
+heap_allocations(void) {
+	return SDL_AtomicGet(&allocation_count);
+}
+
+
+/* Routes SDL's own allocations (and those of SDL_ttf and SDL_image, which allocate through SDL) through the counter. Must be
+ * called before `SDL_Init`. */
+void
+count_sdl_allocations(void) {
+	SDL_GetMemoryFunctions(&sdl_malloc, &sdl_calloc, &sdl_realloc, &sdl_free);
+	SDL_SetMemoryFunctions(counting_malloc, counting_calloc, counting_realloc, sdl_free);
+}
+
+
+/* SDL's `malloc`, counted. */
+static void*
+counting_malloc(size_t size) {
+	SDL_AtomicAdd(&allocation_count, 1);
+	return sdl_malloc(size);
+}
+
+
+/* SDL's `calloc`, counted. */
+static void*
+counting_calloc(size_t count, size_t size) {
+	SDL_AtomicAdd(&allocation_count, 1);
+	return sdl_calloc(count, size);
+}
+
+
+/* SDL's `realloc`, counted. */
+static void*
+counting_realloc(void* memory, size_t size) {
+	SDL_AtomicAdd(&allocation_count, 1);
+	return sdl_realloc(memory, size);
+}
@@ -0,0 +1,30 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include "SDL.h"
+
+#define ARENA_ALIGNMENT 16
+
+
+/* A bump allocator over one block. Allocations are never freed one by one; the whole arena is reset at once, so an arena that is
+ * reset every frame (or every game) costs no heap allocations after it is set up. */
+typedef struct {
+	Uint8* base;
+	size_t size;
+	size_t used;
+} Arena;
+
+
+void new_arena(Arena* arena, size_t size);
+void free_arena(Arena* arena);
+void* arena_alloc(Arena* arena, size_t size);
+void arena_reset(Arena* arena);
+
+void* heap_alloc(size_t size);
+void* heap_realloc(void* memory, size_t size);
+void heap_free(void* memory);
+long heap_allocations(void);
+void count_sdl_allocations(void);
+
+#endif
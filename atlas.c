@@ -0,0 +1,27 @@
+#include <string.h>
+#include "atlas.h"
+
+
+// A build without the generated `atlas_data.c` (e.g. the Visual Studio project, which has no bake step) gets an empty atlas.
+#ifndef SQUARE_JUMP_BAKED_ATLAS
+const int atlas_num_entries = 0;
+const AtlasEntry atlas_entries[1];
+const int atlas_width = 0;
+const int atlas_height = 0;
+const Uint8 atlas_bits[1];
+#endif
+
+
+/* Returns the baked entry for `text` in `font`, or NULL if it wasn't baked. */
+const AtlasEntry*
+atlas_find(int font, const char* text) {
+
+	int i;
+
+	for (i = 0; i < atlas_num_entries; i++) {
+		if (atlas_entries[i].font == font && strcmp(atlas_entries[i].text, text) == 0) {
+			return &atlas_entries[i];
+		}
+	}
+	return NULL;
+}
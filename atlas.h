@@ -0,0 +1,64 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "SDL.h"
+#include "game.h"
+
+#define FONT "res/yoster.ttf"
+
+// Fonts of the game, by size. Baked text is looked up by font id, so these are shared by the game and the bake tool.
+#define FONT_TITLE 0
+#define FONT_LEVEL 1
+#define FONT_MESSAGE 2
+#define FONT_OVERLAY 3
+#define NUM_FONTS 4
+
+#define TITLE_SIZE W_HEIGHT / 7.5
+#define INSTRUCTION_SIZE TITLE_SIZE / 2
+#define LEVEL_SIZE 24
+#define OVERLAY_SIZE 14
+
+// Point size of each font, by id.
+#define FONT_SIZES { TITLE_SIZE, LEVEL_SIZE, INSTRUCTION_SIZE, OVERLAY_SIZE }
+
+#define TITLE "SQUARE JUMP"
+#define STR_INSTRUCTION_1 "S TO START"
+#define STR_INSTRUCTION_2 "SPACE TO JUMP FORWARD"
+#define STR_INSTRUCTION_3 "RIGHT ARROW KEY TO MOVE FORWARD"
+#define GAME_OVER "GAME OVER"
+#define SEED_LABEL "SEED "
+#define LEVEL "LEVEL"
+
+// Every font but the title's also gets these single characters baked, for text that is put together at run time (the seed, the
+// level letter and the overlay). Lower case is drawn upper case.
+#define FIRST_BAKED_GLYPH ' '
+#define LAST_BAKED_GLYPH '_'
+
+// The atlas is packed into rows of this width; its height is whatever the baked text needs.
+#define ATLAS_WIDTH 1024
+#define ATLAS_TEXT_LENGTH 48
+
+
+/* One baked string: the font it was rendered in, its text, and where its pixels are in the atlas. */
+typedef struct {
+	int font;
+	char text[ATLAS_TEXT_LENGTH];
+	int x;
+	int y;
+	int w;
+	int h;
+} AtlasEntry;
+
+
+/* Text baked at build time by `square-jump-bake`. The image is one bit per pixel, set where a glyph covers it, rows of
+ * `atlas_width / 8` bytes. A build without a baked atlas has no entries and renders all text live. */
+extern const int atlas_num_entries;
+extern const AtlasEntry atlas_entries[];
+extern const int atlas_width;
+extern const int atlas_height;
+extern const Uint8 atlas_bits[];
+
+
+const AtlasEntry* atlas_find(int font, const char* text);
+
+#endif
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SDL.h"
+#include "SDL_ttf.h"
+#include "atlas.h"
+
+#define MAX_ENTRIES 512
+#define BAKE_PADDING 1
+
+
+/* A string to bake. Lists end with NULL text. */
+typedef struct {
+	int font;
+	const char* text;
+} BakeString;
+
+
+// The fixed strings of each screen. The title is also baked in the level font, since the HUD label is sized by it.
+static const BakeString bake_strings[] = {
+	{ FONT_TITLE, TITLE },
+	{ FONT_TITLE, GAME_OVER },
+	{ FONT_LEVEL, LEVEL },
+	{ FONT_LEVEL, TITLE },
+	{ FONT_MESSAGE, STR_INSTRUCTION_1 },
+	{ FONT_MESSAGE, STR_INSTRUCTION_2 },
+	{ 0, NULL }
+};
+
+
+static AtlasEntry entries[MAX_ENTRIES];
+static SDL_Surface* surfaces[MAX_ENTRIES];
+static int num_entries = 0;
+
+
+static void bake(TTF_Font* font, int font_id, const char* text);
+static int write_atlas(const char* path, int height, const Uint8* bits);
+
+
+/* Build step: renders the game's fixed strings and glyphs with `FONT` at every size the game uses and writes them, packed into
+ * a one bit per pixel atlas with their metrics, as a C source file. The game then starts without touching FreeType. If the font
+ * can't be read, an empty atlas is written and the game renders all of its text live.
+ *
+ *     square-jump-bake res/yoster.ttf atlas_data.c */
+int
+main(int argc, char* argv[]) {
+
+	int i, font_id, x = 0, y = 0, row_height = 0, height, stride, px, py;
+	const double sizes[NUM_FONTS] = FONT_SIZES;
+	char glyph[2] = { 0, 0 };
+	size_t font_data_size;
+	void* font_data;
+	TTF_Font* font;
+	Uint8* bits;
+	SDL_Surface* surface;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s FONT OUTPUT\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (SDL_Init(0) != 0 || TTF_Init() != 0) {
+		fprintf(stderr, "could not initialize SDL_ttf\n");
+		return EXIT_FAILURE;
+	}
+
+	// The font file is read once and every size is opened from memory.
+	if ((font_data = SDL_LoadFile(argv[1], &font_data_size)) == NULL) {
+		fprintf(stderr, "could not read %s, writing an empty atlas\n", argv[1]);
+		return write_atlas(argv[2], 0, NULL) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	for (font_id = 0; font_id < NUM_FONTS; font_id++) {
+		if ((font = TTF_OpenFontRW(SDL_RWFromConstMem(font_data, (int)font_data_size), 1, (int)sizes[font_id])) == NULL) {
+			fprintf(stderr, "could not open %s: %s\n", argv[1], TTF_GetError());
+			return EXIT_FAILURE;
+		}
+		for (i = 0; bake_strings[i].text != NULL; i++) {
+			if (bake_strings[i].font == font_id) {
+				bake(font, font_id, bake_strings[i].text);
+			}
+		}
+		if (font_id != FONT_TITLE) {
+			for (glyph[0] = FIRST_BAKED_GLYPH; glyph[0] <= LAST_BAKED_GLYPH; glyph[0]++) {
+				bake(font, font_id, glyph);
+			}
+		}
+		TTF_CloseFont(font);
+	}
+	SDL_free(font_data);
+
+	// Shelf packing: entries fill rows left to right, and a row is as tall as its tallest entry.
+	for (i = 0; i < num_entries; i++) {
+		if (x + entries[i].w > ATLAS_WIDTH) {
+			x = 0;
+			y += row_height + BAKE_PADDING;
+			row_height = 0;
+		}
+		entries[i].x = x;
+		entries[i].y = y;
+		x += entries[i].w + BAKE_PADDING;
+		row_height = (entries[i].h > row_height) ? entries[i].h : row_height;
+	}
+	height = y + row_height;
+
+	stride = ATLAS_WIDTH / 8;
+	bits = (Uint8*)calloc((size_t)stride * height + 1, 1);
+	for (i = 0; i < num_entries; i++) {
+		surface = surfaces[i];
+		SDL_LockSurface(surface);
+		// Solid text is an 8-bit surface where index 0 is the background and anything else is the glyph.
+		for (py = 0; py < entries[i].h; py++) {
+			for (px = 0; px < entries[i].w; px++) {
+				if (((Uint8*)surface->pixels)[py * surface->pitch + px] != 0) {
+					bits[(entries[i].y + py) * stride + (entries[i].x + px) / 8] |= 0x80 >> ((entries[i].x + px) % 8);
+				}
+			}
+		}
+		SDL_UnlockSurface(surface);
+		SDL_FreeSurface(surface);
+	}
+
+	if (!write_atlas(argv[2], height, bits)) {
+		fprintf(stderr, "could not write %s\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+	printf("baked %d strings into a %dx%d atlas (%d bytes)\n", num_entries, ATLAS_WIDTH, height, stride * height);
+	free(bits);
+
+	TTF_Quit();
+	SDL_Quit();
+	return EXIT_SUCCESS;
+}
+
+
+/* Renders `text` in `font` and adds it to the entries, unpacked. Text that renders to nothing is skipped. */
+static void
+bake(TTF_Font* font, int font_id, const char* text) {
+
+	SDL_Colour colour = { 255, 255, 255, 255 };
+	SDL_Surface* surface;
+	AtlasEntry* entry;
+
+	if (num_entries == MAX_ENTRIES || strlen(text) >= ATLAS_TEXT_LENGTH ||
+		(surface = TTF_RenderText_Solid(font, text, colour)) == NULL) {
+		fprintf(stderr, "skipping \"%s\" in font %d\n", text, font_id);
+		return;
+	}
+
+	entry = &entries[num_entries];
+	entry->font = font_id;
+	strcpy(entry->text, text);
+	entry->w = surface->w;
+	entry->h = surface->h;
+	surfaces[num_entries++] = surface;
+}
+
+
+/* Writes the entries and the `height` rows of `bits` as C source defining the tables declared in atlas.h. Returns FALSE if the
+ * file could not be written. */
+static int
+write_atlas(const char* path, int height, const Uint8* bits) {
+
+	int i, n = (ATLAS_WIDTH / 8) * height;
+	const char* c;
+	FILE* out;
+
+	if ((out = fopen(path, "w")) == NULL) {
+		return FALSE;
+	}
+
+	fprintf(out, "/* Generated by square-jump-bake from %s. Do not edit. */\n\n#include \"atlas.h\"\n\n", FONT);
+	fprintf(out, "const int atlas_num_entries = %d;\n", num_entries);
+	fprintf(out, "const int atlas_width = %d;\n", (height > 0) ? ATLAS_WIDTH : 0);
+	fprintf(out, "const int atlas_height = %d;\n\n", height);
+
+	fprintf(out, "const AtlasEntry atlas_entries[%d] = {\n", (num_entries > 0) ? num_entries : 1);
+	for (i = 0; i < num_entries; i++) {
+		fprintf(out, "\t{ %d, \"", entries[i].font);
+		for (c = entries[i].text; *c != '\0'; c++) {
+			fprintf(out, (*c == '"' || *c == '\\') ? "\\%c" : "%c", *c);
+		}
+		fprintf(out, "\", %d, %d, %d, %d },\n", entries[i].x, entries[i].y, entries[i].w, entries[i].h);
+	}
+	fprintf(out, "%s};\n\n", (num_entries > 0) ? "" : "\t{ 0 }\n");
+
+	fprintf(out, "const Uint8 atlas_bits[%d] = {", (n > 0) ? n : 1);
+	for (i = 0; i < n; i++) {
+		fprintf(out, "%s0x%02x,", (i % 16 == 0) ? "\n\t" : " ", bits[i]);
+	}
+	fprintf(out, "%s};\n", (n > 0) ? "\n" : " 0 ");
+
+	return fclose(out) == 0;
+}
@@ -0,0 +1,336 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include "SDL.h"
+#include "game.h"
+#include "bot.h"
+
+#define DEFAULT_GAMES 10000
+#define DEFAULT_OBSTACLES NUM_OBSTACLES
+#define DEFAULT_MAX_TICKS 100000
+#define MAX_THREADS 64
+
+// Survival distance is the number of obstacles passed, counted in buckets of `HISTOGRAM_BUCKET`; the last bucket is open-ended.
+#define HISTOGRAM_BUCKET 5
+#define HISTOGRAM_BUCKETS 20
+#define HISTOGRAM_BAR_WIDTH 40
+
+
+/* The jobs a worker has left, `head` to `tail - 1`. The owner takes jobs from the head; idle workers steal half of what is left
+ * from the tail. */
+typedef struct {
+	SDL_SpinLock lock;
+	int head;
+	int tail;
+} JobQueue;
+
+
+/* One thread of the pool and the results of the games it played. */
+typedef struct {
+	int index;
+	JobQueue queue;
+	long survival[NUM_POLICIES][HISTOGRAM_BUCKETS];
+	long obstacles[NUM_POLICIES];
+	long completed[NUM_POLICIES];
+	long ticks;
+	long steals;
+} Worker;
+
+
+Worker workers[MAX_THREADS];
+int num_workers = 0;
+
+// The batch: every seed from `batch_seed` to `batch_seed + batch_games - 1`, played once by each policy in `batch_policies`.
+int batch_games = DEFAULT_GAMES;
+int batch_course_length = DEFAULT_OBSTACLES;
+long batch_max_ticks = DEFAULT_MAX_TICKS;
+Uint64 batch_seed = 0;
+int batch_policies[NUM_POLICIES];
+int batch_num_policies = 0;
+
+
+double run_batch(int threads, long survival[NUM_POLICIES][HISTOGRAM_BUCKETS], long obstacles[NUM_POLICIES],
+	long completed[NUM_POLICIES], long* ticks, long* steals);
+int worker_main(void* data);
+int take_job(Worker* worker);
+int steal_job(Worker* worker);
+void print_histogram(int policy, long survival[HISTOGRAM_BUCKETS], long obstacles, long completed);
+int parse_count(const char* text, long min, long max, long* value);
+void usage(const char* program);
+
+
+/* Plays a batch of headless games across a work-stealing thread pool, once per thread count up to `--threads`, and reports how
+ * games/sec scales and how far each policy survives. */
+int
+main(int argc, char* argv[]) {
+
+	int i, j, policy, threads, max_threads = SDL_GetCPUCount(), consistent = TRUE;
+	long survival[NUM_POLICIES][HISTOGRAM_BUCKETS], obstacles[NUM_POLICIES], completed[NUM_POLICIES], ticks, steals;
+	long first_survival[NUM_POLICIES][HISTOGRAM_BUCKETS], value;
+	double seconds, base_rate = 0, rate;
+
+	batch_seed = rng_time_seed();
+	for (i = 1; i < argc; i++) {
+		// Every policy plays every game, and the jobs are counted in an int.
+		if (strcmp(argv[i], "--games") == 0 && i + 1 < argc && parse_count(argv[++i], 1, INT_MAX / NUM_POLICIES, &value)) {
+			batch_games = (int)value;
+		}
+		else if (strcmp(argv[i], "--obstacles") == 0 && i + 1 < argc && parse_count(argv[++i], 1, MAX_COURSE_LENGTH, &value)) {
+			batch_course_length = (int)value;
+		}
+		else if (strcmp(argv[i], "--endless") == 0) {
+			batch_course_length = ENDLESS_COURSE;
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			batch_seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc && parse_count(argv[++i], 1, INT_MAX, &value)) {
+			batch_max_ticks = value;
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc && parse_count(argv[++i], 1, MAX_THREADS, &value)) {
+			max_threads = (int)value;
+		}
+		else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+			// Each policy may be named once, or its games would be counted twice into its histogram.
+			policy = policy_from_name(argv[++i]);
+			for (j = 0; j < batch_num_policies && batch_policies[j] != policy; j++) {
+			}
+			if (policy < 0 || j < batch_num_policies || batch_num_policies == NUM_POLICIES) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			batch_policies[batch_num_policies++] = policy;
+		}
+		else {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (batch_num_policies == 0) {
+		for (i = 0; i < NUM_POLICIES; i++) {
+			batch_policies[batch_num_policies++] = i;
+		}
+	}
+	max_threads = (max_threads < 1) ? 1 : ((max_threads > MAX_THREADS) ? MAX_THREADS : max_threads);
+
+	printf("kernel: %s\n", course_kernel_name());
+	printf("seed: %llu\n", (unsigned long long)batch_seed);
+	printf("games_per_policy: %d\n", batch_games);
+	if (batch_course_length == ENDLESS_COURSE) {
+		printf("obstacles: endless\n");
+	}
+	else {
+		printf("obstacles: %d\n", batch_course_length);
+	}
+	printf("\n%-8s %10s %14s %14s %8s %8s\n", "threads", "seconds", "games_per_sec", "ticks_per_sec", "speedup", "steals");
+
+	// Thread counts double up to the maximum, which is always included.
+	for (threads = 1; ; threads = (threads * 2 < max_threads) ? (threads * 2) : max_threads) {
+		seconds = run_batch(threads, survival, obstacles, completed, &ticks, &steals);
+		rate = (seconds > 0) ? (double)batch_games * batch_num_policies / seconds : 0;
+		if (threads == 1) {
+			base_rate = rate;
+			memcpy(first_survival, survival, sizeof(survival));
+		}
+		else if (memcmp(first_survival, survival, sizeof(survival)) != 0) {
+			consistent = FALSE;
+		}
+		printf("%-8d %10.3f %14.0f %14.0f %8.2f %8ld\n", threads, seconds, rate, (seconds > 0) ? ticks / seconds : 0.0,
+			(base_rate > 0) ? rate / base_rate : 0.0, steals);
+		if (threads == max_threads) {
+			break;
+		}
+	}
+
+	// Every game is a pure function of its seed and policy, so the results must not depend on the thread count.
+	printf("\nconsistent: %s\n", consistent ? "yes" : "no");
+	for (i = 0; i < batch_num_policies; i++) {
+		print_histogram(batch_policies[i], survival[batch_policies[i]], obstacles[batch_policies[i]], completed[batch_policies[i]]);
+	}
+
+	return consistent ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/* Prints command line usage. */
+void
+usage(const char* program) {
+	fprintf(stderr, "usage: %s [--games N] [--obstacles N | --endless] [--seed N] [--max-ticks N] [--threads N]"
+		" [--policy random|scripted|dawdle]...\n", program);
+}
+
+
+/* Reads `text` as a whole decimal number from `min` to `max` into `value`. Returns FALSE if it is anything else, so a typo can't
+ * quietly become 0 (an endless course) or a length no course can hold. */
+int
+parse_count(const char* text, long min, long max, long* value) {
+
+	char* end;
+
+	errno = 0;
+	*value = strtol(text, &end, 10);
+	return end != text && *end == '\0' && errno == 0 && *value >= min && *value <= max;
+}
+
+
+/* Plays the whole batch on `threads` threads and sums the workers' results. Returns the wall clock time in seconds. */
+double
+run_batch(int threads, long survival[NUM_POLICIES][HISTOGRAM_BUCKETS], long obstacles[NUM_POLICIES],
+	long completed[NUM_POLICIES], long* ticks, long* steals) {
+
+	int i, p, b, total_jobs = batch_games * batch_num_policies;
+	SDL_Thread* handles[MAX_THREADS];
+	Uint64 start_counter;
+
+	// Jobs start out split evenly; stealing evens out whatever imbalance the game lengths create.
+	num_workers = threads;
+	for (i = 0; i < threads; i++) {
+		memset(&workers[i], 0, sizeof(Worker));
+		workers[i].index = i;
+		workers[i].queue.head = (int)((long)total_jobs * i / threads);
+		workers[i].queue.tail = (int)((long)total_jobs * (i + 1) / threads);
+	}
+
+	start_counter = SDL_GetPerformanceCounter();
+	for (i = 1; i < threads; i++) {
+		handles[i] = SDL_CreateThread(worker_main, "batch worker", &workers[i]);
+		if (handles[i] == NULL) {
+			fprintf(stderr, "could not start thread %d: %s\n", i, SDL_GetError());
+			exit(EXIT_FAILURE);
+		}
+	}
+	worker_main(&workers[0]);
+	for (i = 1; i < threads; i++) {
+		SDL_WaitThread(handles[i], NULL);
+	}
+
+	memset(survival, 0, sizeof(long) * NUM_POLICIES * HISTOGRAM_BUCKETS);
+	memset(obstacles, 0, sizeof(long) * NUM_POLICIES);
+	memset(completed, 0, sizeof(long) * NUM_POLICIES);
+	*ticks = 0;
+	*steals = 0;
+	for (i = 0; i < threads; i++) {
+		for (p = 0; p < NUM_POLICIES; p++) {
+			for (b = 0; b < HISTOGRAM_BUCKETS; b++) {
+				survival[p][b] += workers[i].survival[p][b];
+			}
+			obstacles[p] += workers[i].obstacles[p];
+			completed[p] += workers[i].completed[p];
+		}
+		*ticks += workers[i].ticks;
+		*steals += workers[i].steals;
+	}
+
+	return (double)(SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency();
+}
+
+
+/* Worker thread: plays jobs from its own queue, then steals from the others until no jobs are left anywhere. Job `j` is seed
+ * `batch_seed + j / batch_num_policies` played by policy `j % batch_num_policies`. */
+int
+worker_main(void* data) {
+
+	int job, policy, bucket, completed;
+	Worker* worker = (Worker*)data;
+	Game game;
+	Course course;
+	Arena arena;
+
+	// Each worker owns its game state and course storage, so games never share memory.
+	new_arena(&arena, course_size(batch_course_length));
+
+	while ((job = take_job(worker)) >= 0 || (job = steal_job(worker)) >= 0) {
+		policy = batch_policies[job % batch_num_policies];
+		worker->ticks += play_game(&game, &course, policy, batch_course_length, batch_seed + job / batch_num_policies,
+			batch_max_ticks, &completed, NULL, &arena);
+
+		bucket = game.obstacles_passed / HISTOGRAM_BUCKET;
+		worker->survival[policy][(bucket < HISTOGRAM_BUCKETS) ? bucket : (HISTOGRAM_BUCKETS - 1)]++;
+		worker->obstacles[policy] += game.obstacles_passed;
+		worker->completed[policy] += completed;
+		free_course(&course);
+	}
+
+	free_arena(&arena);
+	return 0;
+}
+
+
+/* Takes the next job from the worker's own queue. Returns -1 when it is empty. */
+int
+take_job(Worker* worker) {
+
+	int job = -1;
+
+	SDL_AtomicLock(&worker->queue.lock);
+	if (worker->queue.head < worker->queue.tail) {
+		job = worker->queue.head++;
+	}
+	SDL_AtomicUnlock(&worker->queue.lock);
+	return job;
+}
+
+
+/* Steals the back half of another worker's remaining jobs, keeps the rest for later and returns the first one. Returns -1 when
+ * every queue is empty; jobs are never added, so the worker can then stop. */
+int
+steal_job(Worker* worker) {
+
+	int i, count, first;
+	Worker* victim;
+
+	for (i = 1; i < num_workers; i++) {
+		victim = &workers[(worker->index + i) % num_workers];
+
+		SDL_AtomicLock(&victim->queue.lock);
+		count = (victim->queue.tail - victim->queue.head + 1) / 2;
+		first = victim->queue.tail - count;
+		victim->queue.tail = first;
+		SDL_AtomicUnlock(&victim->queue.lock);
+
+		if (count > 0) {
+			SDL_AtomicLock(&worker->queue.lock);
+			worker->queue.head = first + 1;
+			worker->queue.tail = first + count;
+			SDL_AtomicUnlock(&worker->queue.lock);
+			worker->steals++;
+			return first;
+		}
+	}
+	return -1;
+}
+
+
+/* Prints how many games of `policy` ended in each survival distance bucket, with a bar for each. */
+void
+print_histogram(int policy, long survival[HISTOGRAM_BUCKETS], long obstacles, long completed) {
+
+	int i, bar;
+	long most = 1;
+	char range[16];
+
+	for (i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		most = (survival[i] > most) ? survival[i] : most;
+	}
+
+	printf("\npolicy: %s\n", policy_names[policy]);
+	printf("mean_obstacles_passed: %.1f\n", (batch_games > 0) ? (double)obstacles / batch_games : 0.0);
+	printf("games_completed: %ld\n", completed);
+	printf("%-10s %8s\n", "obstacles", "games");
+	for (i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		if (i < HISTOGRAM_BUCKETS - 1) {
+			snprintf(range, sizeof(range), "%d-%d", i * HISTOGRAM_BUCKET, (i + 1) * HISTOGRAM_BUCKET - 1);
+		}
+		else {
+			snprintf(range, sizeof(range), "%d+", i * HISTOGRAM_BUCKET);
+		}
+		printf("%-10s %8ld%s", range, survival[i], (survival[i] * HISTOGRAM_BAR_WIDTH / most > 0) ? " " : "");
+		for (bar = 0; bar < survival[i] * HISTOGRAM_BAR_WIDTH / most; bar++) {
+			putchar('#');
+		}
+		putchar('\n');
+	}
+}
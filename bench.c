@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SDL.h"
+#include "game.h"
+#include "course.h"
+#include "arena.h"
+#include "playrender.h"
+
+#define DEFAULT_SECONDS 0.5
+#define DEFAULT_SEED 1
+
+// A benchmark is first run once, then with more ops until a run takes at least the target time; growth is capped per run so a
+// slow first op can't overshoot it by much.
+#define BENCH_MAX_GROWTH 100
+#define BENCH_MAX_OPS 100000000L
+
+#define NUM_LENGTHS 4
+#define MAX_BENCH_LENGTH 5000
+
+// An endless course is run for this many obstacles before the run starts over.
+#define ENDLESS_RUN MAX_BENCH_LENGTH
+
+// The bench loads no fonts, so the HUD is drawn from a blank texture of this size in place of the level label and letter.
+#define HUD_TEXT_WIDTH 96
+#define HUD_TEXT_HEIGHT 32
+
+
+/* State shared by the ops of one benchmark: a course, a game running along it, and the renderer for the render benchmark. */
+typedef struct {
+	Arena arena;
+	Course course;
+	Game game;
+	int length;
+	Uint64 seed;
+	SDL_Renderer* renderer;
+} Bench;
+
+
+/* Runs `ops` ops of a benchmark and returns the performance counter ticks they took. */
+typedef Uint64 (*BenchFunc)(Bench* bench, long ops);
+
+
+// Course lengths every benchmark runs at; `ENDLESS_COURSE` (0) streams an endless course through its ring.
+const int course_lengths[NUM_LENGTHS] = { 50, 500, MAX_BENCH_LENGTH, ENDLESS_COURSE };
+
+SDL_Colour bg_colour = { 0, 0, 0 };
+SDL_Colour player_colour = { 0, 255, 0 };
+SDL_Colour floor_colour = { 0, 0, 255 };
+SDL_Colour ghost_colour = { 0, 96, 0 };
+
+
+void run_bench(const char* name, BenchFunc func, Bench* bench, int length, double seconds);
+void start_run(Bench* bench);
+void run_along(Bench* bench);
+Uint64 bench_generate(Bench* bench, long ops);
+Uint64 bench_collide(Bench* bench, long ops);
+Uint64 bench_scroll(Bench* bench, long ops);
+Uint64 bench_render(Bench* bench, long ops);
+void prepare_hud(SDL_Renderer* renderer);
+void usage(const char* program);
+
+
+/* Benchmarks the game's hot paths one at a time, at several course lengths, and prints one CSV row per benchmark with the time
+ * and heap allocations (SDL's included) per op. Runs without a display: SDL's dummy video driver is used unless
+ * `SDL_VIDEODRIVER` names another. */
+int
+main(int argc, char* argv[]) {
+
+	int i;
+	double seconds = DEFAULT_SECONDS;
+	SDL_Window* window = NULL;
+	Bench bench;
+
+	bench.seed = DEFAULT_SEED;
+	bench.renderer = NULL;
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			bench.seed = strtoull(argv[++i], NULL, 10);
+		}
+		else {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	count_sdl_allocations();
+	SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+	if (SDL_Init(SDL_INIT_VIDEO) != 0 || (window = SDL_CreateWindow("Square Jump bench", SDL_WINDOWPOS_CENTERED,
+		SDL_WINDOWPOS_CENTERED, W_WIDTH, W_HEIGHT, 0)) == NULL || (bench.renderer = SDL_CreateRenderer(window, -1, 0)) == NULL) {
+		fprintf(stderr, "no renderer, skipping the render benchmark: %s\n", SDL_GetError());
+	}
+
+	// Room for the longest course, reused by every benchmark.
+	new_arena(&bench.arena, course_size(MAX_BENCH_LENGTH));
+
+	printf("benchmark,obstacles,kernel,ops,ns_per_op,allocs_per_op\n");
+	for (i = 0; i < NUM_LENGTHS; i++) {
+		run_bench("generate", bench_generate, &bench, course_lengths[i], seconds);
+	}
+	for (i = 0; i < NUM_LENGTHS; i++) {
+		run_bench("collide", bench_collide, &bench, course_lengths[i], seconds);
+	}
+	for (i = 0; i < NUM_LENGTHS; i++) {
+		run_bench("scroll", bench_scroll, &bench, course_lengths[i], seconds);
+	}
+	if (bench.renderer != NULL) {
+		prepare_hud(bench.renderer);
+		prepare_layers(bench.renderer);
+	}
+	for (i = 0; i < NUM_LENGTHS && bench.renderer != NULL; i++) {
+		run_bench("render", bench_render, &bench, course_lengths[i], seconds);
+	}
+
+	free_arena(&bench.arena);
+	if (bench.renderer != NULL) {
+		free_layers();
+		if (hud_label_text.texture != NULL) {
+			SDL_DestroyTexture(hud_label_text.texture);
+		}
+		SDL_DestroyRenderer(bench.renderer);
+	}
+	if (window != NULL) {
+		SDL_DestroyWindow(window);
+	}
+	SDL_Quit();
+	return EXIT_SUCCESS;
+}
+
+
+/* Prints command line usage. */
+void
+usage(const char* program) {
+	fprintf(stderr, "usage: %s [--seconds S] [--seed N]\n", program);
+}
+
+
+/* Places a stand-in for the game's HUD text along the bottom of the screen: the level label and letter share one blank texture,
+ * so the HUD layer is drawn and copied as the game's is. */
+void
+prepare_hud(SDL_Renderer* renderer) {
+
+	hud_label_text.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, HUD_TEXT_WIDTH,
+		HUD_TEXT_HEIGHT);
+	hud_label_text.source.x = 0;
+	hud_label_text.source.y = 0;
+	hud_label_text.source.w = HUD_TEXT_WIDTH;
+	hud_label_text.source.h = HUD_TEXT_HEIGHT;
+	hud_label_text.rect = hud_label_text.source;
+	hud_label_text.rect.y = W_HEIGHT - HUD_TEXT_HEIGHT;
+
+	hud_level_text = hud_label_text;
+	hud_level_text.rect.x = 2 * HUD_TEXT_WIDTH;
+}
+
+
+/* Runs benchmark `func` on a course of `length` obstacles with more and more ops until one run takes `seconds`, then prints its
+ * row. */
+void
+run_bench(const char* name, BenchFunc func, Bench* bench, int length, double seconds) {
+
+	long ops = 1, next, allocations;
+	Uint64 ticks, target = (Uint64)(seconds * SDL_GetPerformanceFrequency());
+
+	bench->length = length;
+	arena_reset(&bench->arena);
+	new_course(&bench->course, length, bench->seed, &bench->arena);
+	start_run(bench);
+
+	for (;;) {
+		allocations = heap_allocations();
+		ticks = func(bench, ops);
+		allocations = heap_allocations() - allocations;
+		if (ticks >= target || ops >= BENCH_MAX_OPS) {
+			break;
+		}
+		next = (ticks > 0) ? (long)(ops * 1.2 * target / ticks) : ops * BENCH_MAX_GROWTH;
+		ops = (next > ops * BENCH_MAX_GROWTH) ? (ops * BENCH_MAX_GROWTH) : ((next > ops) ? next : ops + 1);
+		if (ops > BENCH_MAX_OPS) {
+			ops = BENCH_MAX_OPS;
+		}
+	}
+
+	printf("%s,%d,%s,%ld,%.1f,%.3f\n", name, length, course_kernel_name(), ops,
+		ticks * 1e9 / SDL_GetPerformanceFrequency() / ops, (double)allocations / ops);
+	fflush(stdout);
+}
+
+
+/* Puts the player back at the start of the course. An endless course is rebuilt from its seed, since its early obstacles have
+ * been recycled. */
+void
+start_run(Bench* bench) {
+	if (bench->course.endless) {
+		arena_reset(&bench->arena);
+		new_course(&bench->course, bench->length, bench->seed, &bench->arena);
+	}
+	new_game(&bench->game);
+}
+
+
+/* Moves the player one tick's run along the course and scrolls after it, as `update` does: the obstacle cursor slides past the
+ * obstacles left behind, the camera follows the player and an endless course streams obstacles in ahead and recycles those
+ * behind. The player keeps the first level's speed, so every op covers the same distance however far the run has got. Starts over
+ * past the end of a finite course, or once an endless one has generated `ENDLESS_RUN` obstacles. */
+void
+run_along(Bench* bench) {
+
+	Game* game = &bench->game;
+	Course* course = &bench->course;
+	int last = (course->end - 1) & course->mask, speed = PLAYER_SPEED;
+
+	advance_cursor(game, course);
+	game->player.x += speed + (speed / 2);
+	screen_scroll(game);
+	stream_course(course, game->camera_x);
+	if (course->endless ? (course->end >= ENDLESS_RUN) : (game->player.x > course->x[last] + course->w[last])) {
+		start_run(bench);
+	}
+}
+
+
+/* One op generates a whole course; an endless one only up to the end of its streaming window. */
+Uint64
+bench_generate(Bench* bench, long ops) {
+
+	long i;
+	Uint64 start = SDL_GetPerformanceCounter();
+
+	for (i = 0; i < ops; i++) {
+		arena_reset(&bench->arena);
+		new_course(&bench->course, bench->length, bench->seed + i, &bench->arena);
+	}
+	return SDL_GetPerformanceCounter() - start;
+}
+
+
+/* One op is a tick's run and scroll, as `bench_scroll` measures alone, and its collision check (`colliding_obstacle`, whose
+ * cursor advance `run_along` has already made). The player never jumps, so it may be left dying; the check runs all the same. */
+Uint64
+bench_collide(Bench* bench, long ops) {
+
+	long i;
+	Uint64 start = SDL_GetPerformanceCounter();
+
+	for (i = 0; i < ops; i++) {
+		run_along(bench);
+		colliding_obstacle(&bench->game, &bench->course);
+	}
+	return SDL_GetPerformanceCounter() - start;
+}
+
+
+/* One op is a tick's run and scroll (see `run_along`). */
+Uint64
+bench_scroll(Bench* bench, long ops) {
+
+	long i;
+	Uint64 start = SDL_GetPerformanceCounter();
+
+	for (i = 0; i < ops; i++) {
+		run_along(bench);
+	}
+	return SDL_GetPerformanceCounter() - start;
+}
+
+
+/* One op is a frame's draw submission through `render_play`, as the game makes it: the cached background, floor and HUD
+ * layers, the visible obstacles in one batch per colour, and the player. Only the submission is timed; the run along the course
+ * and the present that sends the batch to the renderer are not. */
+Uint64
+bench_render(Bench* bench, long ops) {
+
+	long i;
+	Uint64 start, ticks = 0;
+	Game* game = &bench->game;
+	SDL_Rect player;
+	SDL_Rect bg_rect = { 0, 0, W_WIDTH, W_HEIGHT };
+	SDL_Rect floor_rect = { 0, INITIAL_FLOOR_Y, W_WIDTH, INITIAL_FLOOR_HEIGHT };
+
+	for (i = 0; i < ops; i++) {
+		run_along(bench);
+		colliding_obstacle(game, &bench->course);
+
+		start = SDL_GetPerformanceCounter();
+		player = game->player;
+		player.x -= game->camera_x;
+		render_play(bench->renderer, game, &bench->course, game->camera_x, &bg_rect, &floor_rect, &player, NULL, 0, bg_colour,
+			floor_colour, player_colour, ghost_colour);
+		ticks += SDL_GetPerformanceCounter() - start;
+
+		SDL_RenderPresent(bench->renderer);
+	}
+	return ticks;
+}
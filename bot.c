@@ -0,0 +1,119 @@
+#include <string.h>
+#include "bot.h"
+
+
+const char* policy_names[NUM_POLICIES] = { "random", "scripted", "dawdle" };
+
+
+/* Returns the policy called `name`, or -1 if there is none. */
+int
+policy_from_name(const char* name) {
+
+	int i;
+
+	for (i = 0; i < NUM_POLICIES; i++) {
+		if (strcmp(name, policy_names[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+/* Plays one game on the course of `seed`, built in `arena`, to the end of the course, the player's death or `max_ticks`. Returns
+ * the number of ticks simulated and leaves the final state in `game` and `course`. The game's inputs are written to `recording`
+ * unless it is NULL. Games share nothing, so any number can be played at once on different threads. */
+long
+play_game(Game* game, Course* course, int policy, int course_length, Uint64 seed, long max_ticks, int* completed,
+	Replay* recording, Arena* arena) {
+
+	long ticks = 0;
+	Rng rng;
+
+	arena_reset(arena);
+	new_course(course, course_length, seed, arena);
+	new_game(game);
+	rng_seed(&rng, ~seed);
+	*completed = FALSE;
+
+	while (game->player_state != PLAYER_DEAD && ticks < max_ticks) {
+		if (course_finished(game, course)) {
+			*completed = TRUE;
+			break;
+		}
+		if (wants_jump(game, course, policy, &rng)) {
+			game_command(game, COMMAND_JUMP);
+			if (recording != NULL) {
+				replay_record(recording, game->tick, REPLAY_JUMP);
+			}
+		}
+		update(game, course, TICK_SECONDS);
+		ticks++;
+	}
+
+	if (recording != NULL) {
+		recording->seed = seed;
+		replay_finish(recording, game->tick, game_checksum(game, course));
+	}
+
+	return ticks;
+}
+
+
+/* Returns TRUE once the player is past the last obstacle of a finite course. */
+int
+course_finished(Game* game, Course* course) {
+	return !course->endless && game->obstacle_cursor >= course->end;
+}
+
+
+/* Input policy. The random policy presses SPACE on roughly one tick in `RANDOM_JUMP_CHANCE`, drawing from `rng`. The scripted
+ * policy jumps when a hole or floor block is about to be reached, jumps again in mid-air to clear wide holes and tall blocks, and
+ * never jumps under a ceiling block. The dawdling policy plays as the scripted one but also hops now and then on open floor, where
+ * a jump covers less ground than running, so its games trail the scripted ones on the same course. */
+int
+wants_jump(Game* game, Course* course, int policy, Rng* rng) {
+
+	int i, gap, kind;
+	SDL_Rect obstacle;
+
+	if (policy == POLICY_RANDOM) {
+		return rng_range(rng, RANDOM_JUMP_CHANCE) == 0;
+	}
+
+	if (game->player_state == PLAYER_DYING || game->player_state == PLAYER_DEAD) {
+		return FALSE;
+	}
+
+	if (policy == POLICY_DAWDLE && game->player_state == PLAYER_RUNNING && game->tick % DAWDLE_TICKS == 0 &&
+		game->floor_y == FLOOR_Y) {
+		for (i = game->obstacle_cursor; i < course->end && course->x[i & course->mask] + course->w[i & course->mask] <= game->player.x;
+			i++) {
+		}
+		if (i < course->end && course->x[i & course->mask] - (game->player.x + PLAYER_WIDTH) >= DAWDLE_CLEARANCE) {
+			return TRUE;
+		}
+	}
+
+	for (i = game->obstacle_cursor; i < course->end; i++) {
+		obstacle = course_rect(course, i);
+		kind = course_kind(course, i);
+		if (obstacle.x + obstacle.w <= game->player.x) {
+			continue;
+		}
+		if (kind == OBSTACLE_CEILING) {
+			return FALSE;
+		}
+
+		gap = obstacle.x - (game->player.x + PLAYER_WIDTH);
+		if (game->player_state == PLAYER_RUNNING) {
+			return gap >= 0 && gap < ((kind == OBSTACLE_HOLE) ? LOOKAHEAD_DISTANCE : HALF_JUMP_WIDTH);
+		}
+		if (kind == OBSTACLE_HOLE) {
+			return game->player_state == PLAYER_FALLING && gap < 0 && (game->player.y + PLAYER_HEIGHT) >= (HOLE_Y - PLAYER_HEIGHT);
+		}
+		return gap < LOOKAHEAD_DISTANCE && (game->player.y + PLAYER_HEIGHT) > obstacle.y && game->arc_x > -(HALF_JUMP_WIDTH / 2);
+	}
+
+	return FALSE;
+}
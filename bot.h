@@ -0,0 +1,29 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "game.h"
+#include "replay.h"
+
+#define POLICY_RANDOM 0
+#define POLICY_SCRIPTED 1
+#define POLICY_DAWDLE 2
+#define NUM_POLICIES 3
+
+#define RANDOM_JUMP_CHANCE 40
+#define LOOKAHEAD_DISTANCE (HALF_JUMP_WIDTH / 2)
+
+// The dawdling policy hops on one tick in `DAWDLE_TICKS` where the floor is clear for a whole jump and a look ahead after it.
+#define DAWDLE_TICKS 30
+#define DAWDLE_CLEARANCE (2 * HALF_JUMP_WIDTH + LOOKAHEAD_DISTANCE)
+
+
+extern const char* policy_names[NUM_POLICIES];
+
+
+int policy_from_name(const char* name);
+int wants_jump(Game* game, Course* course, int policy, Rng* rng);
+int course_finished(Game* game, Course* course);
+long play_game(Game* game, Course* course, int policy, int course_length, Uint64 seed, long max_ticks, int* completed,
+	Replay* recording, Arena* arena);
+
+#endif
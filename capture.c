@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SDL.h"
+#include "game.h"
+#include "replay.h"
+#include "ghost.h"
+#include "softrender.h"
+#include "framedump.h"
+
+
+Uint32 hash_canvas(const Canvas* canvas, Uint32 hash);
+void usage(const char* program);
+
+
+/* Plays back a recorded game with no window or renderer, drawing every tick with the software renderer, and optionally writes the
+ * frames out from a background thread: a numbered PNG each (`--out`) or one raw RGBA stream (`--raw`). Reports the cost of a
+ * frame and a hash of every frame drawn, to compare against a golden run. */
+int
+main(int argc, char* argv[]) {
+
+	int i, realtime = FALSE, format = DUMP_PNG, num_ghosts = 0, ok = TRUE;
+	const char* replay_path = NULL;
+	const char* dump_path = NULL;
+	const char* ghost_paths[MAX_GHOSTS];
+	long frames = 0, written = 0;
+	Uint32 hash = 2166136261u;
+	Uint64 render_counter = 0, start;
+	double seconds;
+	Replay replay;
+	Replay ghost_sources[MAX_GHOSTS];
+	GhostRace ghosts;
+	Game game;
+	Course course;
+	Arena level_arena;
+	Canvas local;
+	Canvas* canvas;
+	SDL_Colour bg_colour = { 0, 0, 0 };
+	SDL_Colour font_colour = { 0, 255, 0 };
+	SDL_Colour player_colour = { 0, 255, 0 };
+	SDL_Colour ghost_colour = { 0, 96, 0 };
+	SDL_Colour floor_colour = { 0, 0, 255 };
+	Palette palette;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replay_path = argv[++i];
+		}
+		else if (strcmp(argv[i], "--ghost") == 0 && i + 1 < argc && num_ghosts < MAX_GHOSTS) {
+			ghost_paths[num_ghosts++] = argv[++i];
+		}
+		else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+			dump_path = argv[++i];
+			format = DUMP_PNG;
+		}
+		else if (strcmp(argv[i], "--raw") == 0 && i + 1 < argc) {
+			dump_path = argv[++i];
+			format = DUMP_RAW;
+		}
+		else if (strcmp(argv[i], "--realtime") == 0) {
+			realtime = TRUE;
+		}
+		else {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (replay_path == NULL || (dump_path != NULL && format == DUMP_PNG && !valid_frame_pattern(dump_path))) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (!load_replay(&replay, replay_path)) {
+		fprintf(stderr, "could not read replay %s\n", replay_path);
+		return EXIT_FAILURE;
+	}
+	if (load_ghost_replays(ghost_sources, ghost_paths, num_ghosts) != num_ghosts ||
+		(num_ghosts > 0 && (ghost_sources[0].seed != replay.seed || ghost_sources[0].course_length != replay.course_length))) {
+		fprintf(stderr, "ghosts must be replays of the course of %s\n", replay_path);
+		return EXIT_FAILURE;
+	}
+
+	new_arena(&level_arena, course_size(replay.course_length) + canvas_size(W_WIDTH, W_HEIGHT) +
+		((num_ghosts > 0) ? ghost_race_size(num_ghosts, replay.course_length) : 0));
+	new_course(&course, replay.course_length, replay.seed, &level_arena);
+	new_canvas(&local, W_WIDTH, W_HEIGHT, &level_arena);
+	if (num_ghosts > 0) {
+		new_ghost_race(&ghosts, ghost_sources, num_ghosts, 1, &level_arena);
+	}
+	new_game(&game);
+
+	palette.background = canvas_colour(bg_colour);
+	palette.floor = canvas_colour(floor_colour);
+	palette.player = canvas_colour(player_colour);
+	palette.ghost = canvas_colour(ghost_colour);
+	palette.font = canvas_colour(font_colour);
+
+	if (dump_path != NULL && !start_frame_dump(dump_path, format, W_WIDTH, W_HEIGHT, !realtime)) {
+		fprintf(stderr, "could not write %s\n", dump_path);
+		return EXIT_FAILURE;
+	}
+
+	// Every tick is drawn whole, as the game would show it on a display refreshing at the tick rate. As fast as possible, the game
+	// waits for the writer so no frame is lost; at the game's own tick rate it never waits, and frames the writer can't keep up
+	// with are dropped, as they would be while the game is played.
+	start = SDL_GetPerformanceCounter();
+	while (game.tick < replay.final_tick) {
+		replay_apply(&replay, &game);
+		update(&game, &course, TICK_SECONDS);
+		if (num_ghosts > 0) {
+			update_ghosts(&ghosts, TICK_SECONDS);
+		}
+
+		// Sleeps until the wall clock catches up with the simulation.
+		while (realtime && (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency() <
+			game.tick * TICK_SECONDS) {
+			SDL_Delay(1);
+		}
+
+		canvas = (dump_path != NULL) ? dump_acquire() : &local;
+		if (canvas == NULL) {
+			continue;
+		}
+		Uint64 render_start = SDL_GetPerformanceCounter();
+		soft_render(canvas, &palette, &game, &course, (num_ghosts > 0) ? &ghosts : NULL, 1.0);
+		render_counter += SDL_GetPerformanceCounter() - render_start;
+		hash = hash_canvas(canvas, hash);
+		frames++;
+		if (dump_path != NULL) {
+			dump_submit();
+		}
+	}
+	if (dump_path != NULL) {
+		written = stop_frame_dump();
+		ok = (written >= 0);
+	}
+	seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+	printf("replay: %s\n", replay_path);
+	printf("kernel: %s\n", canvas_kernel_name());
+	printf("ghosts: %d\n", num_ghosts);
+	printf("ticks: %u\n", replay.final_tick);
+	printf("frames: %ld\n", frames);
+	printf("seconds: %.6f\n", seconds);
+	printf("render_ns: %.1f\n", (frames > 0) ? render_counter * 1e9 / SDL_GetPerformanceFrequency() / frames : 0.0);
+	printf("frames_per_sec: %.0f\n", (seconds > 0) ? frames / seconds : 0.0);
+	if (dump_path != NULL) {
+		printf("output: %s\n", dump_path);
+		printf("frames_written: %ld\n", written);
+		printf("frames_dropped: %ld\n", dump_dropped());
+	}
+	printf("frames_hash: %08x\n", hash);
+	printf("result: %s\n", ok ? "ok" : "write failed");
+
+	if (num_ghosts > 0) {
+		free_ghosts(&ghosts);
+	}
+	free_course(&course);
+	free_arena(&level_arena);
+	free_replay(&replay);
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/* Prints command line usage. */
+void
+usage(const char* program) {
+	fprintf(stderr, "usage: %s --replay FILE [--ghost FILE]... [--out PATTERN | --raw FILE] [--realtime]\n", program);
+	fprintf(stderr, "       PATTERN numbers each frame's PNG with exactly one %%ld, e.g. frames/%%05ld.png\n");
+}
+
+
+/* Adds the pixels of `canvas` to an FNV-1a hash, a pixel at a time, so two runs drew the same frames if they end with the same
+ * hash. */
+Uint32
+hash_canvas(const Canvas* canvas, Uint32 hash) {
+
+	size_t i, n = (size_t)canvas->width * canvas->height;
+
+	for (i = 0; i < n; i++) {
+		hash = (hash ^ canvas->pixels[i]) * 16777619u;
+	}
+	return hash;
+}
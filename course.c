@@ -0,0 +1,504 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <assert.h>
+#include <math.h>
+#include "game.h"
+
+// The range kernel is picked at compile time: AVX2 when the compiler targets it, SSE2 on any x86-64 build, scalar otherwise.
+// Define SQUARE_JUMP_SCALAR to force the scalar fallback.
+#if !defined(SQUARE_JUMP_SCALAR) && defined(__AVX2__)
+#include <immintrin.h>
+#define KERNEL_NAME "avx2"
+#define KERNEL_LANES 8
+#elif !defined(SQUARE_JUMP_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define KERNEL_NAME "sse2"
+#define KERNEL_LANES 4
+#else
+#define KERNEL_NAME "scalar"
+#define KERNEL_LANES 1
+#endif
+
+
+// Verification follows the continuous jump arc, which has the same shape in world x at every speed, without counting on jumping
+// again in mid-air. The player only takes off where a running step lands it, so takeoffs are tried every `ARC_SAMPLE_STEP` pixels
+// and only count inside a passable window at least one running step wide; clearances must be good by `ARC_MARGIN` pixels plus
+// the most a tick-sampled arc can sag below the true one. Speeds past `MAX_VERIFIED_SPEED` are treated as that speed.
+#define JUMP_HEIGHT (JUMP_DILATION * (HALF_JUMP_WIDTH) * (HALF_JUMP_WIDTH))
+#define ARC_SAMPLE_STEP 16
+#define ARC_MARGIN 2
+#define MAX_VERIFIED_SPEED 40
+#define OBSTACLE_ATTEMPTS 8
+
+
+static int course_capacity(int length);
+static int find_range_span(const Course* course, int start, int n, int number, int left, int right, int* out);
+static void generate_obstacle(Course* course, int slot);
+static void repair_obstacle(Course* course, int slot);
+static int verified_speed(int i);
+static void try_takeoffs(const Course* course, int i, int first, int last, double ground_y, int* floor_x, CourseReach* next);
+static int trace_arc(const Course* course, int i, double from, double apex_x, double apex_y, int* floor_x, CourseReach* next);
+
+
+/* Returns the number of slots a course of `length` obstacles is stored in. */
+static int
+course_capacity(int length) {
+
+	int capacity = 1;
+
+	assert(length >= 0 && length <= MAX_COURSE_LENGTH);
+	while (capacity < ((length == ENDLESS_COURSE) ? COURSE_CAPACITY : length)) {
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+
+/* Returns the arena space `new_course` needs for a course of `length` obstacles. */
+size_t
+course_size(int length) {
+	return course_capacity(length) * (4 * sizeof(int) + sizeof(Uint8)) + ARENA_ALIGNMENT;
+}
+
+
+/* Sets up a course of `length` obstacles generated from `seed`, or an endless one streamed through a ring of `COURSE_CAPACITY` slots
+ * when `length` is `ENDLESS_COURSE`. All storage comes from `arena` (at least `course_size(length)` bytes free), once; the course
+ * lives until the arena is reset. */
+void
+new_course(Course* course, int length, Uint64 seed, Arena* arena) {
+
+	course->endless = (length == ENDLESS_COURSE);
+	course->capacity = course_capacity(length);
+	course->mask = course->capacity - 1;
+	course->first = 0;
+	course->end = 0;
+	course->generated = 0;
+	course->hold = INT_MAX;
+	course->next_x = (W_WIDTH / 2) + OBSTACLE_SPACING;
+	course->seed = seed;
+	rng_seed(&course->rng, seed);
+	course->reach.floor_x = PLAYER_SCREEN_X;
+	course->reach.top_x = NO_REACH;
+	course->rejected = 0;
+	course->repaired = 0;
+	course->unpassable = 0;
+	course->generate_counter = 0;
+	course->verify_counter = 0;
+
+	// One block holds every array: x, y, w and h, then the kind tags.
+	course->x = (int*)arena_alloc(arena, course->capacity * (4 * sizeof(int) + sizeof(Uint8)));
+	course->y = course->x + course->capacity;
+	course->w = course->y + course->capacity;
+	course->h = course->w + course->capacity;
+	course->kind = (Uint8*)(course->h + course->capacity);
+
+	if (course->endless) {
+		stream_course(course, 0);
+	}
+	else {
+		while (course->end < length) {
+			add_obstacle(course);
+		}
+	}
+}
+
+
+/* Detaches a course from its storage. The storage itself goes back when its arena is reset. */
+void
+free_course(Course* course) {
+	course->x = course->y = course->w = course->h = NULL;
+	course->kind = NULL;
+	course->first = 0;
+	course->end = 0;
+}
+
+
+/* Recycles obstacles that the camera has scrolled past, up to `course->hold`, and refills their slots with new obstacles just
+ * ahead of the screen. Does nothing for finite courses. */
+void
+stream_course(Course* course, int camera) {
+
+	int slot;
+
+	if (!course->endless) {
+		return;
+	}
+
+	while (course->first < course->end && course->first < course->hold) {
+		slot = course->first & course->mask;
+		if (course->x[slot] + course->w[slot] >= camera) {
+			break;
+		}
+		course->first++;
+	}
+
+	while ((course->end - course->first) < course->capacity && course->next_x < (camera + STREAM_AHEAD)) {
+		add_obstacle(course);
+	}
+}
+
+
+/* Saves where `course` is: its live window and generator state. */
+void
+save_course_cursor(const Course* course, CourseCursor* cursor) {
+	cursor->first = course->first;
+	cursor->end = course->end;
+	cursor->next_x = course->next_x;
+	cursor->rng = course->rng;
+	cursor->reach = course->reach;
+	cursor->rejected = course->rejected;
+	cursor->repaired = course->repaired;
+	cursor->unpassable = course->unpassable;
+}
+
+
+/* Puts `course` back where `cursor` was saved. The slots usually still hold the saved window, since an endless course only
+ * recycles a slot well after its obstacle has left the screen. If they don't (the window was recycled, or was never generated since
+ * the course was last rewound), the course is generated again from its seed, which costs one generation per obstacle. */
+void
+restore_course_cursor(Course* course, const CourseCursor* cursor) {
+
+	if (cursor->first < course->generated - course->capacity || cursor->end > course->generated) {
+		course->first = 0;
+		course->end = 0;
+		course->next_x = (W_WIDTH / 2) + OBSTACLE_SPACING;
+		rng_seed(&course->rng, course->seed);
+		course->reach.floor_x = PLAYER_SCREEN_X;
+		course->reach.top_x = NO_REACH;
+		while (course->end < cursor->end) {
+			if (course->end - course->first == course->capacity) {
+				course->first++;
+			}
+			add_obstacle(course);
+		}
+		// Generation is deterministic, so the course must have arrived in the saved state.
+		assert(course->next_x == cursor->next_x);
+		course->generated = course->end;
+	}
+
+	course->first = cursor->first;
+	course->end = cursor->end;
+	course->next_x = cursor->next_x;
+	course->rng = cursor->rng;
+	course->reach = cursor->reach;
+	course->rejected = cursor->rejected;
+	course->repaired = cursor->repaired;
+	course->unpassable = cursor->unpassable;
+}
+
+
+/* Appends a hole or obstacle of arbitrary size after the last obstacle of `course`. A candidate the player couldn't get past is
+ * thrown away and drawn again; after `OBSTACLE_ATTEMPTS` failures the segment is repaired with the narrowest hole, placed where
+ * the player can always jump it from the floor (see `repair_obstacle`). Generation never loops on a repair: one that still fails
+ * the check is kept, counted in `unpassable`, and the player is taken to have got past it. */
+void
+add_obstacle(Course* course) {
+
+	int slot = course->end & course->mask, attempt, passable = FALSE;
+	Uint64 start_counter = SDL_GetPerformanceCounter(), verify_start;
+	CourseReach reach;
+
+	for (attempt = 0; attempt <= OBSTACLE_ATTEMPTS && !passable; attempt++) {
+		if (attempt < OBSTACLE_ATTEMPTS) {
+			generate_obstacle(course, slot);
+		}
+		else {
+			repair_obstacle(course, slot);
+		}
+
+		verify_start = SDL_GetPerformanceCounter();
+		reach = course->reach;
+		passable = verify_obstacle(course, course->end, &reach);
+		course->verify_counter += SDL_GetPerformanceCounter() - verify_start;
+		course->rejected += (!passable && attempt < OBSTACLE_ATTEMPTS);
+	}
+
+	if (!passable) {
+		course->unpassable++;
+		reach.floor_x = course->x[slot] + course->w[slot];
+		reach.top_x = NO_REACH;
+	}
+	course->reach = reach;
+	course->next_x = course->x[slot] + course->w[slot] + OBSTACLE_SPACING;
+	course->end++;
+	if (course->end > course->generated) {
+		course->generated = course->end;
+	}
+	course->generate_counter += SDL_GetPerformanceCounter() - start_counter;
+}
+
+
+/* Puts the narrowest hole into `slot` at the earliest x the player can jump it from. That is a running step past the earliest
+ * floor the player can reach, where it either already is or comes down by running off the top of the obstacle before, and no
+ * earlier than `next_x`. The player can then take off anywhere in the last `2 * HALF_JUMP_WIDTH + PLAYER_WIDTH - HOLE_WIDTH`
+ * pixels before the hole, wider than a running step at any verified speed, and lands well short of the next obstacle. */
+static void
+repair_obstacle(Course* course, int slot) {
+
+	int step = verified_speed(course->end) + (verified_speed(course->end) / 2), floor_x = course->reach.floor_x, land_x;
+
+	if (course->reach.top_x != NO_REACH) {
+		// As in `verify_obstacle`, the player can be level up to two running steps past the end of the top before it falls.
+		land_x = course->reach.top_end + 2 * step + (int)ceil(sqrt((FLOOR_Y - course->reach.top_y) / JUMP_DILATION));
+		floor_x = (land_x < floor_x) ? land_x : floor_x;
+	}
+
+	course->x[slot] = (floor_x + step > course->next_x) ? (floor_x + step) : course->next_x;
+	course->y[slot] = HOLE_Y;
+	course->w[slot] = HOLE_WIDTH;
+	course->h[slot] = HOLE_HEIGHT;
+	course->kind[slot] = OBSTACLE_HOLE;
+	course->repaired++;
+}
+
+
+/* Draws a hole or obstacle of arbitrary size into `slot`, after the last obstacle of `course`. */
+static void
+generate_obstacle(Course* course, int slot) {
+
+	int kind = rng_range(&course->rng, 3), obstacle_x, obstacle_width, obstacle_height;
+
+	if (kind == OBSTACLE_HOLE) {
+		obstacle_width = HOLE_WIDTH + rng_range(&course->rng, (int)XTEND_HOLE_WIDTH);
+		obstacle_x = course->next_x + rng_range(&course->rng, (int)XTEND_OBSTACLE_SPACING);
+		course->y[slot] = HOLE_Y;
+		course->h[slot] = HOLE_HEIGHT;
+	}
+	else if (kind == OBSTACLE_FLOOR) {
+		obstacle_width = OBSTACLE_WIDTH + rng_range(&course->rng, (int)XTEND_OBSTACLE_WIDTH);
+		obstacle_height = OBSTACLE_HEIGHT + rng_range(&course->rng, (int)XTEND_OBSTACLE_HEIGHT);
+		obstacle_x = course->next_x + rng_range(&course->rng, (int)XTEND_OBSTACLE_SPACING);
+		course->y[slot] = FLOOR_Y - obstacle_height;
+		course->h[slot] = obstacle_height;
+	}
+	else {
+		obstacle_width = OBSTACLE_WIDTH + rng_range(&course->rng, (int)XTEND_OBSTACLE_WIDTH);
+		obstacle_height = OBSTACLE_HEIGHT + rng_range(&course->rng, (int)XTEND_OBSTACLE_HEIGHT);
+		obstacle_height = (obstacle_height < (W_HEIGHT / 2)) ? (W_HEIGHT / 2) : obstacle_height;
+		obstacle_x = course->next_x + rng_range(&course->rng, (int)XTEND_OBSTACLE_SPACING);
+		course->y[slot] = 0;
+		course->h[slot] = obstacle_height;
+	}
+
+	course->x[slot] = obstacle_x;
+	course->w[slot] = obstacle_width;
+	course->kind[slot] = (Uint8)kind;
+}
+
+
+/* Works out which surfaces around obstacle `i` the player can reach, given what it could reach just before it in `reach`, and
+ * updates `reach` to match. The player can get there from the top of the obstacle before, by running off its end or jumping
+ * anywhere along it, or from the floor, by jumping anywhere it can stand. Returns `FALSE` if the player can reach neither the top
+ * of obstacle `i` nor the floor after it. */
+int
+verify_obstacle(const Course* course, int i, CourseReach* reach) {
+
+	SDL_Rect obstacle = course_rect(course, i);
+	int kind = course_kind(course, i), floor_x = reach->floor_x, ignored = NO_REACH, run_off;
+	CourseReach next = { NO_REACH, NO_REACH, obstacle.y, obstacle.x + obstacle.w };
+
+	if (reach->top_x != NO_REACH) {
+		// The player only finds the top has ended on the tick after it runs off, and starts to fall a tick after that, so it can
+		// still be level up to two running steps past the end.
+		run_off = reach->top_end + 2 * (verified_speed(i) + (verified_speed(i) / 2));
+		trace_arc(course, i, run_off, run_off, reach->top_y, &floor_x, &next);
+		// Jumps that come down on the same top again get nowhere.
+		try_takeoffs(course, i, (reach->top_x > reach->top_end - 2 * HALF_JUMP_WIDTH) ? reach->top_x :
+			(reach->top_end - 2 * HALF_JUMP_WIDTH), reach->top_end - 1, reach->top_y, &floor_x, &next);
+	}
+
+	if (floor_x != NO_REACH) {
+		if (kind == OBSTACLE_CEILING) {
+			// The player runs underneath.
+			next.floor_x = obstacle.x + obstacle.w;
+		}
+		else {
+			try_takeoffs(course, i, floor_x, (kind == OBSTACLE_HOLE) ? obstacle.x : (int)(obstacle.x - PLAYER_WIDTH), FLOOR_Y,
+				&ignored, &next);
+		}
+	}
+
+	if (kind != OBSTACLE_FLOOR) {
+		next.top_x = NO_REACH;
+	}
+	*reach = next;
+	return next.floor_x != NO_REACH || next.top_x != NO_REACH;
+}
+
+
+/* Returns the running speed the player will have when it reaches obstacle `i`, up to `MAX_VERIFIED_SPEED`. */
+static int
+verified_speed(int i) {
+
+	int speed = (int)PLAYER_SPEED + (i / 5);
+
+	return (speed < MAX_VERIFIED_SPEED) ? speed : MAX_VERIFIED_SPEED;
+}
+
+
+/* Tries jumps towards obstacle `i` from player x `first` to `last` on ground at height `ground_y`, and lowers `floor_x` and the
+ * fields of `next` to the earliest landings of every run of takeoffs that is at least a running step wide. */
+static void
+try_takeoffs(const Course* course, int i, int first, int last, double ground_y, int* floor_x, CourseReach* next) {
+
+	int takeoff, run_start = NO_REACH, window = verified_speed(i) + (verified_speed(i) / 2), run_floor_x;
+	CourseReach run;
+
+	for (takeoff = first; takeoff <= last; takeoff = (takeoff < last && takeoff + ARC_SAMPLE_STEP > last) ? last :
+		(takeoff + ARC_SAMPLE_STEP)) {
+		if (run_start == NO_REACH) {
+			run_floor_x = NO_REACH;
+			run.floor_x = run.top_x = NO_REACH;
+		}
+		if (!trace_arc(course, i, takeoff, takeoff + HALF_JUMP_WIDTH, ground_y - JUMP_HEIGHT, &run_floor_x, &run)) {
+			run_start = NO_REACH;
+			continue;
+		}
+		run_start = (run_start == NO_REACH) ? takeoff : run_start;
+		if (takeoff - run_start >= window) {
+			*floor_x = (run_floor_x < *floor_x) ? run_floor_x : *floor_x;
+			next->floor_x = (run.floor_x < next->floor_x) ? run.floor_x : next->floor_x;
+			next->top_x = (run.top_x < next->top_x) ? run.top_x : next->top_x;
+		}
+	}
+}
+
+
+/* Follows the player along the arc y = `apex_y` + JUMP_DILATION (x - `apex_x`)^2 of its bottom edge, starting from player x
+ * `from`, to where it first meets obstacle `i` or the floor. Landing on the floor before the obstacle lowers `floor_x`, landing on
+ * its top or the floor after it lowers the matching field of `next`. Landings after the obstacle only count while they are clear
+ * of wherever the next obstacle could start. Returns `FALSE` if the player runs into the obstacle or falls down the hole. */
+static int
+trace_arc(const Course* course, int i, double from, double apex_x, double apex_y, int* floor_x, CourseReach* next) {
+
+	SDL_Rect obstacle = course_rect(course, i);
+	int kind = course_kind(course, i), speed = verified_speed(i);
+	double land_x = apex_x + sqrt((FLOOR_Y - apex_y) / JUMP_DILATION), margin = ARC_MARGIN + (JUMP_DILATION * speed * speed / 4);
+	double enter_x, low_x, after_x;
+
+	if (kind == OBSTACLE_FLOOR) {
+		if (land_x <= obstacle.x - PLAYER_WIDTH) {
+			*floor_x = (land_x < *floor_x) ? (int)land_x : *floor_x;
+			return TRUE;
+		}
+		// The player must be above the top by the time it reaches the obstacle, then either come down on it or clear it.
+		enter_x = (from > obstacle.x - PLAYER_WIDTH) ? from : (obstacle.x - PLAYER_WIDTH);
+		if (apex_y + JUMP_DILATION * (enter_x - apex_x) * (enter_x - apex_x) > obstacle.y - margin) {
+			return FALSE;
+		}
+		low_x = apex_x + sqrt((obstacle.y - apex_y) / JUMP_DILATION);
+		if (low_x < obstacle.x + obstacle.w) {
+			next->top_x = ((int)ceil(low_x) < next->top_x) ? (int)ceil(low_x) : next->top_x;
+			return TRUE;
+		}
+		after_x = land_x;
+	}
+	else if (kind == OBSTACLE_HOLE) {
+		if (land_x <= obstacle.x) {
+			*floor_x = (land_x < *floor_x) ? (int)land_x : *floor_x;
+			return TRUE;
+		}
+		if (land_x + PLAYER_WIDTH < obstacle.x + obstacle.w) {
+			return FALSE;
+		}
+		after_x = land_x;
+	}
+	else {
+		// Wherever the player is under the ceiling its head must stay below it; the arc is highest at its lowest x there.
+		enter_x = (from > obstacle.x - PLAYER_WIDTH) ? from : (obstacle.x - PLAYER_WIDTH);
+		low_x = (land_x < obstacle.x + obstacle.w) ? land_x : (obstacle.x + obstacle.w);
+		if (enter_x < low_x) {
+			low_x = (apex_x < enter_x) ? enter_x : ((apex_x > low_x) ? low_x : apex_x);
+			if (apex_y + JUMP_DILATION * (low_x - apex_x) * (low_x - apex_x) - PLAYER_HEIGHT < obstacle.y + obstacle.h + margin) {
+				return FALSE;
+			}
+		}
+		if (land_x <= obstacle.x - PLAYER_WIDTH) {
+			*floor_x = (land_x < *floor_x) ? (int)land_x : *floor_x;
+			return TRUE;
+		}
+		after_x = (land_x > obstacle.x + obstacle.w) ? land_x : (obstacle.x + obstacle.w);
+	}
+
+	if (after_x + PLAYER_WIDTH > obstacle.x + obstacle.w + OBSTACLE_SPACING) {
+		return FALSE;
+	}
+	next->floor_x = ((int)ceil(after_x) < next->floor_x) ? (int)ceil(after_x) : next->floor_x;
+	return TRUE;
+}
+
+
+/* Writes to `out`, in order, the numbers of the obstacles `from` to `to - 1` whose x-range overlaps [left, right), and returns how
+ * many there are. Used both as the collision broadphase and to cull obstacles against the screen. */
+int
+course_find_range(const Course* course, int from, int to, int left, int right, int* out) {
+
+	int start = from & course->mask, n = to - from, first_span, found;
+
+	assert(from >= course->first && to <= course->end);
+	if (n <= 0) {
+		return 0;
+	}
+
+	// The live obstacles may wrap around the end of the ring, so they are scanned as up to two contiguous spans.
+	first_span = (n < course->capacity - start) ? n : (course->capacity - start);
+	found = find_range_span(course, start, first_span, from, left, right, out);
+	if (n > first_span) {
+		found += find_range_span(course, 0, n - first_span, from + first_span, left, right, out + found);
+	}
+	return found;
+}
+
+
+/* Returns the name of the range kernel this build uses. */
+const char*
+course_kernel_name(void) {
+	return KERNEL_NAME;
+}
+
+
+/* Range kernel over `n` contiguous slots starting at `start`; the first of them is obstacle `number`. */
+static int
+find_range_span(const Course* course, int start, int n, int number, int left, int right, int* out) {
+
+	int i = 0, found = 0;
+	const int* x = course->x + start;
+	const int* w = course->w + start;
+
+#if KERNEL_LANES == 8
+	int lane, hits;
+	__m256i v_left = _mm256_set1_epi32(left), v_right = _mm256_set1_epi32(right), v_x, v_end, v_hit;
+	for (; i + 8 <= n; i += 8) {
+		v_x = _mm256_loadu_si256((const __m256i*)(x + i));
+		v_end = _mm256_add_epi32(v_x, _mm256_loadu_si256((const __m256i*)(w + i)));
+		v_hit = _mm256_and_si256(_mm256_cmpgt_epi32(v_right, v_x), _mm256_cmpgt_epi32(v_end, v_left));
+		hits = _mm256_movemask_ps(_mm256_castsi256_ps(v_hit));
+		for (lane = 0; hits != 0; lane++, hits >>= 1) {
+			if (hits & 1) {
+				out[found++] = number + i + lane;
+			}
+		}
+	}
+#elif KERNEL_LANES == 4
+	int lane, hits;
+	__m128i v_left = _mm_set1_epi32(left), v_right = _mm_set1_epi32(right), v_x, v_end, v_hit;
+	for (; i + 4 <= n; i += 4) {
+		v_x = _mm_loadu_si128((const __m128i*)(x + i));
+		v_end = _mm_add_epi32(v_x, _mm_loadu_si128((const __m128i*)(w + i)));
+		v_hit = _mm_and_si128(_mm_cmplt_epi32(v_x, v_right), _mm_cmpgt_epi32(v_end, v_left));
+		hits = _mm_movemask_ps(_mm_castsi128_ps(v_hit));
+		for (lane = 0; hits != 0; lane++, hits >>= 1) {
+			if (hits & 1) {
+				out[found++] = number + i + lane;
+			}
+		}
+	}
+#endif
+
+	for (; i < n; i++) {
+		if (x[i] < right && (x[i] + w[i]) > left) {
+			out[found++] = number + i;
+		}
+	}
+	return found;
+}
@@ -0,0 +1,103 @@
+#ifndef COURSE_H
+#define COURSE_H
+
+#include "SDL.h"
+#include "rng.h"
+#include "arena.h"
+
+#define ENDLESS_COURSE 0
+#define COURSE_CAPACITY 64
+// Longest finite course, so the slot count of any course fits an int.
+#define MAX_COURSE_LENGTH (1 << 20)
+
+#define OBSTACLE_HOLE 0
+#define OBSTACLE_FLOOR 1
+#define OBSTACLE_CEILING 2
+
+#define NO_REACH 0x7fffffff
+
+
+/* What the player can reach just after the last generated obstacle: the earliest player x on the floor after it and, for floor
+ * obstacles, the earliest x on its top, which reaches to `top_end` at height `top_y`. Unreachable surfaces are `NO_REACH`. */
+typedef struct {
+	int floor_x;
+	int top_x;
+	int top_y;
+	int top_end;
+} CourseReach;
+
+
+/* The part of a course that moves during play: the live window of obstacles and the generator state for the next ones. Saving it
+ * is enough to put a course back where it was, since the obstacles themselves follow from the seed. */
+typedef struct {
+	int first;
+	int end;
+	int next_x;
+	Rng rng;
+	CourseReach reach;
+	int rejected;
+	int repaired;
+	int unpassable;
+} CourseCursor;
+
+
+/* Obstacles of a course in world coordinates, sorted by x. They are stored as parallel arrays so the range kernel can test several
+ * obstacles per instruction. Obstacle `i` (counting from the start of the course) lives in slot `i & mask`; only obstacles `first`
+ * to `end - 1` are live. Endless courses recycle the slots of obstacles behind the screen; the slots hold obstacles `generated -
+ * capacity` to `generated - 1`, which may run past `end` after the course is rewound. Nothing from `hold` on is recycled, so a
+ * course shared by several games can keep the obstacles of the one furthest behind. The layout is drawn from the course's own
+ * generator, so a seed always gives the same course, and every obstacle is checked to be passable as it is generated; the
+ * counters record what that costs. */
+typedef struct {
+	int* x;
+	int* y;
+	int* w;
+	int* h;
+	Uint8* kind;
+	int capacity;
+	int mask;
+	int first;
+	int end;
+	int generated;
+	int hold;
+	int next_x;
+	int endless;
+	Uint64 seed;
+	Rng rng;
+	CourseReach reach;
+	int rejected;
+	int repaired;
+	int unpassable;
+	Uint64 generate_counter;
+	Uint64 verify_counter;
+} Course;
+
+
+void new_course(Course* course, int length, Uint64 seed, Arena* arena);
+size_t course_size(int length);
+void free_course(Course* course);
+void stream_course(Course* course, int camera);
+void add_obstacle(Course* course);
+int verify_obstacle(const Course* course, int i, CourseReach* reach);
+void save_course_cursor(const Course* course, CourseCursor* cursor);
+void restore_course_cursor(Course* course, const CourseCursor* cursor);
+int course_find_range(const Course* course, int from, int to, int left, int right, int* out);
+const char* course_kernel_name(void);
+
+
+/* Returns obstacle `i` of `course` as a rect. */
+static inline SDL_Rect
+course_rect(const Course* course, int i) {
+	int slot = i & course->mask;
+	SDL_Rect rect = { course->x[slot], course->y[slot], course->w[slot], course->h[slot] };
+	return rect;
+}
+
+
+/* Returns the kind (`OBSTACLE_HOLE`, `OBSTACLE_FLOOR` or `OBSTACLE_CEILING`) of obstacle `i` of `course`. */
+static inline int
+course_kind(const Course* course, int i) {
+	return course->kind[i & course->mask];
+}
+
+#endif
@@ -0,0 +1,369 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "framedump.h"
+
+#define DUMP_PATH_LENGTH 256
+
+// Stored (uncompressed) deflate blocks hold at most this many bytes.
+#define DEFLATE_BLOCK 65535
+
+// Adler-32 sums are taken modulo ADLER_BASE; ADLER_RUN bytes is the longest run that can't overflow them before reducing.
+#define ADLER_BASE 65521
+#define ADLER_RUN 5552
+
+
+// The frame queue is filled by the caller and drained by the writer thread. `dump_head` is the oldest frame not yet written and
+// `dump_count` the frames waiting or being written; a slot is free again once the writer is done with it.
+Canvas dump_frames[DUMP_QUEUE_SIZE];
+int dump_head = 0;
+int dump_count = 0;
+int dump_acquired = FALSE;
+int dump_running = FALSE;
+int dump_lossless = FALSE;
+int dump_format = DUMP_PNG;
+long dump_written = 0;
+long dump_frames_dropped = 0;
+int dump_failed = FALSE;
+char dump_path[DUMP_PATH_LENGTH];
+FILE* dump_file = NULL;
+SDL_Thread* dump_thread = NULL;
+SDL_mutex* dump_lock = NULL;
+SDL_cond* dump_ready = NULL;
+SDL_cond* dump_freed = NULL;
+
+Uint32 crc_table[256];
+
+
+static int dump_writer(void* data);
+static int write_frame(const Canvas* canvas, long number);
+static Uint32 crc_update(Uint32 crc, const Uint8* bytes, size_t length);
+static int write_chunk(FILE* file, const char* type, const Uint8* data, Uint32 length, Uint32 crc);
+static void put_u32_be(Uint8* out, Uint32 value);
+
+
+/* Starts writing `width` x `height` frames to `path` from a background thread: for `DUMP_PNG` a pattern with one `%ld` for the
+ * frame number (e.g. "frames/%05ld.png", see `valid_frame_pattern`), for `DUMP_RAW` one file that every frame is appended to. A
+ * full queue drops frames, so the caller never waits on the disk, unless `lossless` is set; then it waits for a free slot, for
+ * captures that must have every frame. Returns FALSE if the pattern is not valid, the raw file can't be opened or the writer
+ * thread can't be started. */
+int
+start_frame_dump(const char* path, int format, int width, int height, int lossless) {
+
+	int i;
+	Uint32 c, k;
+
+	assert(!dump_running);
+	if (format == DUMP_PNG && !valid_frame_pattern(path)) {
+		return FALSE;
+	}
+	if (format == DUMP_RAW && (dump_file = fopen(path, "wb")) == NULL) {
+		return FALSE;
+	}
+	snprintf(dump_path, sizeof(dump_path), "%s", path);
+
+	for (i = 0; i < 256; i++) {
+		c = (Uint32)i;
+		for (k = 0; k < 8; k++) {
+			c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+		}
+		crc_table[i] = c;
+	}
+
+	// Every frame buffer is allocated here, so queueing a frame never allocates.
+	for (i = 0; i < DUMP_QUEUE_SIZE; i++) {
+		dump_frames[i].pixels = (Uint32*)heap_alloc((size_t)width * height * sizeof(Uint32));
+		dump_frames[i].width = width;
+		dump_frames[i].height = height;
+	}
+	dump_head = 0;
+	dump_count = 0;
+	dump_acquired = FALSE;
+	dump_format = format;
+	dump_lossless = lossless;
+	dump_written = 0;
+	dump_frames_dropped = 0;
+	dump_failed = FALSE;
+	dump_lock = SDL_CreateMutex();
+	dump_ready = SDL_CreateCond();
+	dump_freed = SDL_CreateCond();
+	dump_running = TRUE;
+	dump_thread = (dump_lock != NULL && dump_ready != NULL && dump_freed != NULL) ?
+		SDL_CreateThread(dump_writer, "frame writer", NULL) : NULL;
+	if (dump_thread == NULL) {
+		fprintf(stderr, "could not start the frame writer: %s\n", SDL_GetError());
+		dump_running = FALSE;
+		for (i = 0; i < DUMP_QUEUE_SIZE; i++) {
+			heap_free(dump_frames[i].pixels);
+		}
+		SDL_DestroyCond(dump_freed);
+		SDL_DestroyCond(dump_ready);
+		SDL_DestroyMutex(dump_lock);
+		if (dump_file != NULL) {
+			fclose(dump_file);
+			dump_file = NULL;
+		}
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+/* Returns TRUE if `pattern` can number PNG frames: it fits a path, and has exactly one conversion, a `%ld` with optional flags and
+ * width, besides any `%%`. It is used as the format of every frame's path, so anything else would read arguments that aren't
+ * there, or write every frame over the same file. */
+int
+valid_frame_pattern(const char* pattern) {
+
+	int conversions = 0;
+	const char* c;
+
+	if (strlen(pattern) >= DUMP_PATH_LENGTH) {
+		return FALSE;
+	}
+	for (c = pattern; *c != '\0'; c++) {
+		if (*c != '%') {
+			continue;
+		}
+		if (*++c == '%') {
+			continue;
+		}
+		c += strspn(c, "-+ #0");
+		c += strspn(c, "0123456789");
+		if (c[0] != 'l' || c[1] != 'd') {
+			return FALSE;
+		}
+		c++;
+		conversions++;
+	}
+	return conversions == 1;
+}
+
+
+/* Returns a canvas to render the next frame into, to be queued with `dump_submit`, or NULL if the queue is full and the frame is
+ * dropped. */
+Canvas*
+dump_acquire(void) {
+
+	Canvas* canvas = NULL;
+
+	assert(dump_running && !dump_acquired);
+	SDL_LockMutex(dump_lock);
+	while (dump_lossless && dump_count == DUMP_QUEUE_SIZE) {
+		SDL_CondWait(dump_freed, dump_lock);
+	}
+	if (dump_count < DUMP_QUEUE_SIZE) {
+		canvas = &dump_frames[(dump_head + dump_count) % DUMP_QUEUE_SIZE];
+		dump_acquired = TRUE;
+	}
+	else {
+		dump_frames_dropped++;
+	}
+	SDL_UnlockMutex(dump_lock);
+	return canvas;
+}
+
+
+/* Queues the frame rendered into the canvas from `dump_acquire` for writing. */
+void
+dump_submit(void) {
+	assert(dump_acquired);
+	SDL_LockMutex(dump_lock);
+	dump_count++;
+	dump_acquired = FALSE;
+	SDL_CondSignal(dump_ready);
+	SDL_UnlockMutex(dump_lock);
+}
+
+
+/* Writes out the queued frames, stops the writer thread and frees the queue. Returns the number of frames written, or -1 if any
+ * could not be. */
+long
+stop_frame_dump(void) {
+
+	int i;
+
+	if (!dump_running) {
+		return 0;
+	}
+	SDL_LockMutex(dump_lock);
+	dump_running = FALSE;
+	SDL_CondSignal(dump_ready);
+	SDL_UnlockMutex(dump_lock);
+	SDL_WaitThread(dump_thread, NULL);
+
+	if (dump_file != NULL && fclose(dump_file) != 0) {
+		dump_failed = TRUE;
+	}
+	for (i = 0; i < DUMP_QUEUE_SIZE; i++) {
+		heap_free(dump_frames[i].pixels);
+	}
+	SDL_DestroyCond(dump_freed);
+	SDL_DestroyCond(dump_ready);
+	SDL_DestroyMutex(dump_lock);
+	dump_file = NULL;
+	dump_thread = NULL;
+	return dump_failed ? -1 : dump_written;
+}
+
+
+/* Returns the number of frames dropped because the queue was full. */
+long
+dump_dropped(void) {
+	return dump_frames_dropped;
+}
+
+
+/* Writer thread: writes the oldest queued frame outside the lock, then frees its slot, until the dump is stopped and drained. */
+static int
+dump_writer(void* data) {
+
+	Canvas* canvas;
+
+	(void)data;
+	for (;;) {
+		SDL_LockMutex(dump_lock);
+		while (dump_count == 0 && dump_running) {
+			SDL_CondWait(dump_ready, dump_lock);
+		}
+		if (dump_count == 0) {
+			SDL_UnlockMutex(dump_lock);
+			return 0;
+		}
+		canvas = &dump_frames[dump_head];
+		SDL_UnlockMutex(dump_lock);
+
+		if (!dump_failed && !write_frame(canvas, dump_written)) {
+			dump_failed = TRUE;
+		}
+		dump_written++;
+
+		SDL_LockMutex(dump_lock);
+		dump_head = (dump_head + 1) % DUMP_QUEUE_SIZE;
+		dump_count--;
+		SDL_CondSignal(dump_freed);
+		SDL_UnlockMutex(dump_lock);
+	}
+}
+
+
+/* Writes frame `number`. Returns FALSE if it could not be written. */
+static int
+write_frame(const Canvas* canvas, long number) {
+
+	char path[DUMP_PATH_LENGTH];
+	FILE* file;
+	int ok;
+
+	if (dump_format == DUMP_RAW) {
+		return fwrite(canvas->pixels, sizeof(Uint32), (size_t)canvas->width * canvas->height, dump_file) ==
+			(size_t)canvas->width * canvas->height;
+	}
+
+	// The pattern was checked by `valid_frame_pattern`; a path cut short by a wide number would overwrite another frame.
+	if (snprintf(path, sizeof(path), dump_path, number) >= (int)sizeof(path) || (file = fopen(path, "wb")) == NULL) {
+		return FALSE;
+	}
+	ok = write_png(file, canvas);
+	return (fclose(file) == 0) && ok;
+}
+
+
+/* Writes `canvas` to `file` as an 8-bit RGBA PNG. The image data goes in stored (uncompressed) deflate blocks, one per row: the
+ * writer only has to keep up with the game, and uncompressed blocks cost nothing but disk. Returns FALSE if the file could not be
+ * written. */
+int
+write_png(FILE* file, const Canvas* canvas) {
+
+	static const Uint8 signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+	Uint8 header[13] = { 0 }, block[6], zlib_header[2] = { 0x78, 0x01 }, adler_bytes[4];
+	Uint32 row_bytes = canvas->width * sizeof(Uint32), block_size = row_bytes + 1, idat_size, crc, adler_a = 1, adler_b = 0;
+	const Uint8* row;
+	int i, n, x, y, ok;
+
+	assert(block_size <= DEFLATE_BLOCK);
+	put_u32_be(header, canvas->width);
+	put_u32_be(header + 4, canvas->height);
+	header[8] = 8;
+	header[9] = 6;
+
+	ok = fwrite(signature, 1, sizeof(signature), file) == sizeof(signature);
+	ok = ok && write_chunk(file, "IHDR", header, sizeof(header), 0xFFFFFFFFu);
+
+	// One IDAT chunk: the zlib header, a stored block per row (its filter byte, 0, then its pixels) and the Adler-32 of the
+	// filtered rows. It is streamed, so its CRC is built as it goes.
+	idat_size = 2 + canvas->height * (5 + block_size) + 4;
+	put_u32_be(block, idat_size);
+	ok = ok && fwrite(block, 1, 4, file) == 4 && fwrite("IDAT", 1, 4, file) == 4 && fwrite(zlib_header, 1, 2, file) == 2;
+	crc = crc_update(0xFFFFFFFFu, (const Uint8*)"IDAT", 4);
+	crc = crc_update(crc, zlib_header, 2);
+
+	for (y = 0; y < canvas->height && ok; y++) {
+		row = (const Uint8*)(canvas->pixels + (size_t)y * canvas->width);
+		block[0] = (y == canvas->height - 1) ? 1 : 0;
+		block[1] = (Uint8)block_size;
+		block[2] = (Uint8)(block_size >> 8);
+		block[3] = (Uint8)~block_size;
+		block[4] = (Uint8)(~block_size >> 8);
+		block[5] = 0;
+		ok = fwrite(block, 1, 6, file) == 6 && fwrite(row, 1, row_bytes, file) == row_bytes;
+		crc = crc_update(crc_update(crc, block, 6), row, row_bytes);
+
+		adler_b = (adler_b + adler_a) % ADLER_BASE;
+		for (x = 0; x < (int)row_bytes; x += n) {
+			// The sums can go ADLER_RUN bytes without overflowing, so they are only reduced once a run.
+			n = ((int)row_bytes - x < ADLER_RUN) ? ((int)row_bytes - x) : ADLER_RUN;
+			for (i = 0; i < n; i++) {
+				adler_a += row[x + i];
+				adler_b += adler_a;
+			}
+			adler_a %= ADLER_BASE;
+			adler_b %= ADLER_BASE;
+		}
+	}
+
+	put_u32_be(adler_bytes, (adler_b << 16) | adler_a);
+	ok = ok && fwrite(adler_bytes, 1, 4, file) == 4;
+	put_u32_be(block, ~crc_update(crc, adler_bytes, 4));
+	ok = ok && fwrite(block, 1, 4, file) == 4;
+
+	return ok && write_chunk(file, "IEND", NULL, 0, 0xFFFFFFFFu);
+}
+
+
+/* Adds `length` bytes to a running CRC-32. */
+static Uint32
+crc_update(Uint32 crc, const Uint8* bytes, size_t length) {
+
+	size_t i;
+
+	for (i = 0; i < length; i++) {
+		crc = crc_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+
+/* Writes a whole PNG chunk of `length` bytes of `data`. `crc` is the starting CRC, all ones for a fresh chunk. */
+static int
+write_chunk(FILE* file, const char* type, const Uint8* data, Uint32 length, Uint32 crc) {
+
+	Uint8 bytes[4];
+	int ok;
+
+	put_u32_be(bytes, length);
+	ok = fwrite(bytes, 1, 4, file) == 4 && fwrite(type, 1, 4, file) == 4 && (length == 0 || fwrite(data, 1, length, file) == length);
+	crc = crc_update(crc, (const Uint8*)type, 4);
+	put_u32_be(bytes, ~crc_update(crc, data, length));
+	return ok && fwrite(bytes, 1, 4, file) == 4;
+}
+
+
+/* Writes `value` as four big-endian bytes, as PNG stores its integers. */
+static void
+put_u32_be(Uint8* out, Uint32 value) {
+	out[0] = (Uint8)(value >> 24);
+	out[1] = (Uint8)(value >> 16);
+	out[2] = (Uint8)(value >> 8);
+	out[3] = (Uint8)value;
+}
@@ -0,0 +1,24 @@
+#ifndef FRAMEDUMP_H
+#define FRAMEDUMP_H
+
+#include "SDL.h"
+#include "softrender.h"
+
+// Frames queued for the writer thread. Each slot is a whole canvas, allocated when the dump starts.
+#define DUMP_QUEUE_SIZE 8
+
+// A numbered PNG per frame, or every frame appended to one file of raw RGBA pixels (e.g. for `ffmpeg -f rawvideo -pix_fmt
+// rgba`).
+#define DUMP_PNG 0
+#define DUMP_RAW 1
+
+
+int start_frame_dump(const char* path, int format, int width, int height, int lossless);
+int valid_frame_pattern(const char* pattern);
+Canvas* dump_acquire(void);
+void dump_submit(void);
+long stop_frame_dump(void);
+long dump_dropped(void);
+int write_png(FILE* file, const Canvas* canvas);
+
+#endif
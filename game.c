@@ -0,0 +1,468 @@
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include "game.h"
+#include "profile.h"
+
+
+// Expands to the arc drop `JUMP_DILATION * x^2` for `x`, `x + 1`, ... so the whole table is a constant initializer.
+#define ARC_DROP_1(x) (JUMP_DILATION * ((x) * (x)))
+#define ARC_DROP_4(x) ARC_DROP_1(x), ARC_DROP_1((x) + 1), ARC_DROP_1((x) + 2), ARC_DROP_1((x) + 3)
+#define ARC_DROP_16(x) ARC_DROP_4(x), ARC_DROP_4((x) + 4), ARC_DROP_4((x) + 8), ARC_DROP_4((x) + 12)
+#define ARC_DROP_64(x) ARC_DROP_16(x), ARC_DROP_16((x) + 16), ARC_DROP_16((x) + 32), ARC_DROP_16((x) + 48)
+#define ARC_DROP_256(x) ARC_DROP_64(x), ARC_DROP_64((x) + 64), ARC_DROP_64((x) + 128), ARC_DROP_64((x) + 192)
+
+// Drop of the jump and fall parabola at each whole-pixel distance from its apex, built by the compiler. Arcs always advance by
+// the integer `jump_speed`, so this one table serves every speed level, including a speed change part way through an arc.
+static const double arc_drops[ARC_TABLE_SIZE] = { ARC_DROP_256(0), ARC_DROP_256(256) };
+
+
+static int sweep_axis(double from, double delta, double low, double high, double* enter, double* exit);
+
+
+/* Resets the game state for a new run and places the player at the start of the course. */
+void
+new_game(Game* game) {
+	game->floor_y = INITIAL_FLOOR_Y;
+	game->is_alive = TRUE;
+	game->player_speed = PLAYER_SPEED;
+	game->jump_speed = JUMP_SPEED;
+	game->hole_collision = FALSE;
+	game->level = ASCII_A;
+
+	game->player_state = PLAYER_RUNNING;
+	game->jump_buffer = 0;
+	game->arc_x = 0;
+	game->arc_start_y = 0;
+	game->dying_speed = 0;
+	game->death_timer = 0;
+
+	game->obstacle_cursor = 0;
+	game->obstacles_passed = 0;
+	game->tick = 0;
+
+	game->player.x = PLAYER_SCREEN_X;
+	game->player.y = game->floor_y - PLAYER_HEIGHT;
+	game->player.w = PLAYER_WIDTH;
+	game->player.h = PLAYER_HEIGHT;
+
+	game->camera_x = 0;
+	game->prev_camera_x = game->camera_x;
+	game->prev_player_x = game->player.x;
+	game->prev_player_y = game->player.y;
+}
+
+
+/* Returns an FNV-1a style hash, taken a word at a time, of the simulation state: the player, the rest of the game state and
+ * the live window of the course. Two runs with the same seed and inputs have the same checksum after the same tick. */
+Uint32
+game_checksum(Game* game, Course* course) {
+
+	int i;
+	Uint64 bits;
+	Uint32 words[20], hash = 2166136261u;
+	double reals[4] = { game->floor_y, game->arc_x, game->arc_start_y, game->death_timer };
+
+	words[0] = game->player.x;
+	words[1] = game->player.y;
+	words[2] = game->player_state;
+	words[3] = game->player_speed;
+	words[4] = game->jump_speed;
+	words[5] = game->level;
+	words[6] = game->camera_x;
+	words[7] = game->obstacle_cursor;
+	words[8] = game->obstacles_passed;
+	words[9] = course->first;
+	words[10] = course->end;
+	words[11] = game->tick;
+	for (i = 0; i < 4; i++) {
+		memcpy(&bits, &reals[i], sizeof(bits));
+		words[12 + 2 * i] = (Uint32)bits;
+		words[13 + 2 * i] = (Uint32)(bits >> 32);
+	}
+
+	for (i = 0; i < 20; i++) {
+		hash = (hash ^ words[i]) * 16777619u;
+	}
+	for (i = course->first; i < course->end; i++) {
+		hash = (hash ^ (Uint32)course->x[i & course->mask]) * 16777619u;
+		hash = (hash ^ (Uint32)course->y[i & course->mask]) * 16777619u;
+	}
+	return hash;
+}
+
+
+/* Bounds checking. */
+void
+is_within_bounds(Game* game) {
+	if ((game->player.x - game->camera_x) < 0 || game->player.y < -PLAYER_HEIGHT) {
+		kill_player(game);
+	}
+}
+
+
+/* Logic for screen scholling. Everything is stored in world coordinates; scrolling only moves the camera, which keeps the player
+ * at `PLAYER_SCREEN_X`. */
+void
+screen_scroll(Game* game) {
+	game->camera_x = game->player.x - PLAYER_SCREEN_X;
+}
+
+
+/* Detects collision between player and obstacles. Adjusts the game's floor as necessary.
+ *
+ * Obstacles are sorted by x and the player only moves forward, so the game's obstacle cursor and count of obstacles passed only
+ * advance. Obstacles are at least `OBSTACLE_SPACING` apart, wider than the player, so every obstacle overlapping the player's
+ * x-range is among the `COLLISION_WINDOW` obstacles after the cursor; the range kernel picks them out, keeping each call O(1) in
+ * course length. */
+void
+colliding_obstacle(Game* game, Course* course) {
+
+	int i, n, kind, window_end, candidates[COLLISION_WINDOW];
+	SDL_Rect obstacle;
+	if (game->is_alive) {
+		advance_cursor(game, course);
+
+		game->hole_collision = FALSE;
+		game->floor_y = FLOOR_Y;
+
+		window_end = (game->obstacle_cursor + COLLISION_WINDOW < course->end) ? (game->obstacle_cursor + COLLISION_WINDOW) : course->end;
+		n = course_find_range(course, game->obstacle_cursor, window_end, game->player.x, game->player.x + PLAYER_WIDTH, candidates);
+
+		for (i = 0; i < n; i++) {
+			obstacle = course_rect(course, candidates[i]);
+			kind = course_kind(course, candidates[i]);
+			// Case 1: Player is on top of obstacle
+			if ((game->player.y <= (obstacle.y - PLAYER_HEIGHT)) && (kind != OBSTACLE_HOLE)) {
+				game->hole_collision = FALSE;
+				game->floor_y = obstacle.y;
+				break;
+			}
+			// Case 2: Player collides with obstacle
+			else if ((SDL_HasIntersection(&game->player, &obstacle) == SDL_TRUE) && (kind != OBSTACLE_HOLE)) {
+				game->player_state = PLAYER_DYING;
+				game->dying_speed = game->player_speed;
+				break;
+			}
+			// Case 3: Player collides with hole
+			else if ((game->player.y >= (HOLE_Y - PLAYER_HEIGHT)) && (game->player.x > obstacle.x) &&
+				((game->player.x + PLAYER_WIDTH) < (obstacle.x + obstacle.w)) && (kind == OBSTACLE_HOLE)) {
+				game->hole_collision = TRUE;
+				game->floor_y = W_HEIGHT + PLAYER_HEIGHT;
+				break;
+			}
+			// Case 4: Player collides with floor
+			else if ((game->player.y >= (obstacle.y - PLAYER_HEIGHT)) && (SDL_HasIntersection(&game->player, &obstacle) == SDL_TRUE)
+				&& ((game->player.x + PLAYER_WIDTH) >= (obstacle.x + obstacle.w)) && (kind == OBSTACLE_HOLE)) {
+				game->floor_y = W_HEIGHT + PLAYER_HEIGHT;
+				game->player_state = PLAYER_DYING;
+				game->dying_speed = game->jump_speed;
+				break;
+			}
+		}
+
+		game->player_speed = PLAYER_SPEED + (game->obstacles_passed / 5);
+		game->jump_speed = JUMP_SPEED + (game->obstacles_passed / 5);
+		game->level = ASCII_A + ((game->obstacles_passed / 5 < MAX_LEVEL) ? (game->obstacles_passed / 5) : MAX_LEVEL);
+	}
+}
+
+
+/* Moves the game's obstacle cursor past the obstacles the player has left behind, and counts those it has reached. */
+void
+advance_cursor(Game* game, Course* course) {
+	while (game->obstacle_cursor < course->end && (course->x[game->obstacle_cursor & course->mask] + course->w[game->obstacle_cursor & course->mask]) <=
+		game->player.x) {
+		game->obstacle_cursor++;
+	}
+	while (game->obstacles_passed < course->end && course->x[game->obstacles_passed & course->mask] < game->player.x) {
+		game->obstacles_passed++;
+	}
+}
+
+
+/* Picks out the obstacles of `course` on a screen whose left edge is at world x `camera`, in screen coordinates, split into the
+ * `blocks` drawn over the floor and the `holes` cut out of it (each with room for `MAX_VISIBLE_OBSTACLES`). Returns the number of
+ * blocks and sets `*num_holes`. */
+int
+visible_obstacles(Game* game, Course* course, int camera, SDL_Rect* blocks, SDL_Rect* holes, int* num_holes) {
+
+	int i, n, from, to, num_blocks = 0, visible[2 * MAX_VISIBLE_OBSTACLES];
+	SDL_Rect obstacle;
+
+	// Every obstacle on screen is within `MAX_VISIBLE_OBSTACLES` of the one under the player.
+	from = (game->obstacle_cursor - MAX_VISIBLE_OBSTACLES > course->first) ? (game->obstacle_cursor - MAX_VISIBLE_OBSTACLES) : course->first;
+	to = (game->obstacle_cursor + MAX_VISIBLE_OBSTACLES < course->end) ? (game->obstacle_cursor + MAX_VISIBLE_OBSTACLES) : course->end;
+	n = course_find_range(course, from, to, camera, camera + W_WIDTH, visible);
+
+	*num_holes = 0;
+	for (i = 0; i < n; i++) {
+		obstacle = course_rect(course, visible[i]);
+		obstacle.x -= camera;
+		if (course_kind(course, visible[i]) == OBSTACLE_HOLE) {
+			holes[(*num_holes)++] = obstacle;
+		}
+		else {
+			blocks[num_blocks++] = obstacle;
+		}
+	}
+	return num_blocks;
+}
+
+
+/* Advances the simulation by one fixed tick of `dt` seconds. Speeds are in pixels per tick, so every tick is identical
+ * regardless of frame rate. */
+void
+update(Game* game, Course* course, double dt) {
+
+	Uint64 phase_start;
+	int from_x, from_y;
+
+	game->prev_camera_x = game->camera_x;
+	game->prev_player_x = game->player.x;
+	game->prev_player_y = game->player.y;
+	game->tick++;
+
+	if (game->player_state == PLAYER_DEAD) {
+		game->death_timer -= dt;
+		return;
+	}
+
+	// Death animation: the player drops to the floor before the game ends.
+	if (game->player_state == PLAYER_DYING) {
+		game->player.y += game->dying_speed;
+		if (game->player.y >= (game->floor_y - PLAYER_HEIGHT)) {
+			game->player.y = game->floor_y - PLAYER_HEIGHT;
+			kill_player(game);
+		}
+		return;
+	}
+
+	// A buffered jump is taken on the first tick the player can jump, or dropped once the buffer runs out.
+	if (game->jump_buffer > 0) {
+		if (can_jump(game)) {
+			jump(game);
+			game->jump_buffer = 0;
+		}
+		else {
+			game->jump_buffer--;
+		}
+	}
+
+	// Collisions are resolved against the position the player is leaving, so landing on an obstacle snaps onto its top.
+	phase_start = phase_begin();
+	colliding_obstacle(game, course);
+	is_within_bounds(game);
+	phase_end(PHASE_COLLISION, phase_start);
+	if (game->player_state == PLAYER_DYING || game->player_state == PLAYER_DEAD) {
+		return;
+	}
+
+	// Running covers the player's speed plus the half-speed automatic scroll of the screen. Each move is swept from the
+	// position the player is leaving, so no step is long enough to pass through the side or top of an obstacle.
+	from_x = game->player.x;
+	from_y = game->player.y;
+	if (game->player_state == PLAYER_RUNNING) {
+		game->player.x += game->player_speed + (game->player_speed / 2);
+		sweep_player(game, course, from_x, from_y);
+		if (game->player_state == PLAYER_RUNNING && game->player.y < (game->floor_y - PLAYER_HEIGHT)) {
+			fall(game);
+		}
+	}
+	else {
+		step_arc(game);
+		game->player.x += game->jump_speed;
+		sweep_player(game, course, from_x, from_y);
+
+		if (game->player_state == PLAYER_FALLING && game->player.y >= (game->floor_y - PLAYER_HEIGHT)) {
+			if (game->hole_collision) {
+				kill_player(game);
+			}
+			else {
+				game->player.y = game->floor_y - PLAYER_HEIGHT;
+				game->player_state = PLAYER_RUNNING;
+			}
+		}
+	}
+
+	phase_start = phase_begin();
+	screen_scroll(game);
+	stream_course(course, game->camera_x);
+	phase_end(PHASE_SCROLL, phase_start);
+}
+
+
+/* Logic for falling from a jump or obstacle. Starts the falling half of the arc from the player's current height. */
+void
+fall(Game* game) {
+	game->player_state = PLAYER_FALLING;
+	game->arc_x = 0;
+	game->arc_start_y = game->player.y;
+}
+
+
+/* Applies a player command to the game. It takes effect on the next update. */
+void
+game_command(Game* game, int type) {
+	if (type == COMMAND_JUMP) {
+		game->jump_buffer = JUMP_BUFFER_TICKS;
+	}
+}
+
+
+/* Returns TRUE if the player can start a jump this tick: running, or in the air, where a new jump cancels the current arc. */
+int
+can_jump(Game* game) {
+	return game->player_state == PLAYER_RUNNING || game->player_state == PLAYER_JUMPING || game->player_state == PLAYER_FALLING;
+}
+
+
+/* Logic for jumping. Starts a new arc from the player's current height, cancelling any arc already under way. */
+void
+jump(Game* game) {
+	game->player_state = PLAYER_JUMPING;
+	game->arc_x = -HALF_JUMP_WIDTH;
+	game->arc_start_y = game->player.y;
+}
+
+
+/* Advances the jump or fall arc by one tick. The rising half ends at the apex (`game->arc_x` == 0), where the fall begins. */
+void
+step_arc(Game* game) {
+
+	game->arc_x += game->jump_speed;
+
+	if (game->player_state == PLAYER_JUMPING) {
+		game->player.y = game->arc_start_y + arc_drop(game->arc_x) - arc_drop(HALF_JUMP_WIDTH);
+		if (game->arc_x >= 0) {
+			fall(game);
+		}
+	}
+	else {
+		game->player.y = game->arc_start_y + arc_drop(game->arc_x);
+	}
+}
+
+
+/* Returns the height the arc has dropped `arc_x` pixels either side of its apex, from the precomputed table while it reaches. */
+double
+arc_drop(double arc_x) {
+
+	int x = (arc_x < 0) ? (int)-arc_x : (int)arc_x;
+
+	if (x < ARC_TABLE_SIZE) {
+		return arc_drops[x];
+	}
+	return JUMP_DILATION * ((double)x * x);
+}
+
+
+/* Finds when a point moving `delta` from `from` is strictly inside (`low`, `high`) along one axis, as fractions of the move.
+ * Returns `FALSE` if it never is. */
+static int
+sweep_axis(double from, double delta, double low, double high, double* enter, double* exit) {
+
+	double t_low, t_high;
+
+	if (delta == 0) {
+		if (from <= low || from >= high) {
+			return FALSE;
+		}
+		*enter = -HUGE_VAL;
+		*exit = HUGE_VAL;
+		return TRUE;
+	}
+	t_low = (low - from) / delta;
+	t_high = (high - from) / delta;
+	*enter = (t_low < t_high) ? t_low : t_high;
+	*exit = (t_low < t_high) ? t_high : t_low;
+	return TRUE;
+}
+
+
+/* Sweeps the player's box along this tick's step of its path, from (`from_x`, `from_y`) to where it is now, against the solid
+ * obstacles in the collision window. Each obstacle is grown by the player's size so the step is a segment against a box, and the
+ * first face the segment enters is resolved at its exact point: coming down onto a top lands the player there, any other face
+ * kills it against that face. Obstacles the player already overlapped are left to `colliding_obstacle`. */
+void
+sweep_player(Game* game, Course* course, int from_x, int from_y) {
+
+	int i, window_end, hit = -1, hit_x = FALSE;
+	double dx = game->player.x - from_x, dy = game->player.y - from_y, t_hit = 1.0;
+	double x_enter, x_exit, y_enter, y_exit, t_enter, t_exit;
+	SDL_Rect obstacle;
+
+	// Obstacles are in x order and none before the cursor reaches the step, so the candidates are the run of obstacles from the
+	// cursor that start before the player's new right edge; usually there are none or one, too few to be worth a range query.
+	window_end = (game->obstacle_cursor + COLLISION_WINDOW < course->end) ? (game->obstacle_cursor + COLLISION_WINDOW) : course->end;
+	for (i = game->obstacle_cursor; i < window_end && course->x[i & course->mask] < game->player.x + PLAYER_WIDTH; i++) {
+		if (course_kind(course, i) == OBSTACLE_HOLE) {
+			continue;
+		}
+		obstacle = course_rect(course, i);
+		// A step that stays above or below the obstacle is the common case and needs no sweep.
+		if (((from_y > game->player.y) ? from_y : game->player.y) <= obstacle.y - PLAYER_HEIGHT ||
+			((from_y < game->player.y) ? from_y : game->player.y) >= obstacle.y + obstacle.h) {
+			continue;
+		}
+		if (!sweep_axis(from_x, dx, obstacle.x - PLAYER_WIDTH, obstacle.x + obstacle.w, &x_enter, &x_exit) ||
+			!sweep_axis(from_y, dy, obstacle.y - PLAYER_HEIGHT, obstacle.y + obstacle.h, &y_enter, &y_exit)) {
+			continue;
+		}
+		t_enter = (x_enter > y_enter) ? x_enter : y_enter;
+		t_exit = (x_exit < y_exit) ? x_exit : y_exit;
+		if (t_enter < 0 || t_enter >= t_exit || t_enter >= t_hit) {
+			continue;
+		}
+		hit = i;
+		t_hit = t_enter;
+		hit_x = (x_enter > y_enter);
+	}
+	if (hit < 0) {
+		return;
+	}
+
+	// Landing keeps the whole step, sliding along the top; any other face stops the player exactly against it, so the point of
+	// contact doesn't depend on rounding the step.
+	obstacle = course_rect(course, hit);
+	if (!hit_x && dy > 0) {
+		game->player.y = obstacle.y - PLAYER_HEIGHT;
+		game->floor_y = obstacle.y;
+		game->hole_collision = FALSE;
+		game->player_state = PLAYER_RUNNING;
+		return;
+	}
+	if (hit_x) {
+		game->player.x = obstacle.x - PLAYER_WIDTH;
+		game->player.y = from_y + (int)(dy * t_hit);
+	}
+	else {
+		game->player.x = from_x + (int)(dx * t_hit);
+		game->player.y = obstacle.y + obstacle.h;
+	}
+	game->player_state = PLAYER_DYING;
+	game->dying_speed = game->player_speed;
+}
+
+
+/* Ends the run. The game-over screen is shown once `game->death_timer` runs out. */
+void
+kill_player(Game* game) {
+	game->is_alive = FALSE;
+	game->player_state = PLAYER_DEAD;
+	game->death_timer = DEATH_PAUSE;
+}
+
+
+/* Returns a SDL_Rect* with: top left vertex (start_coordinate_x, start_coordinate_y) and size `width` X `height`, allocated from
+ * `arena`. */
+SDL_Rect*
+get_rect(Arena* arena, int start_coordinate_x, int start_coordinate_y, int width, int height) {
+	SDL_Rect* rectangle = (SDL_Rect*)arena_alloc(arena, sizeof(SDL_Rect));
+	rectangle->x = start_coordinate_x;
+	rectangle->y = start_coordinate_y;
+	rectangle->w = width;
+	rectangle->h = height;
+	return rectangle;
+}
@@ -0,0 +1,114 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "SDL.h"
+#include "course.h"
+
+#define W_HEIGHT 600
+#define W_WIDTH (W_HEIGHT + (W_HEIGHT * 0.5))
+
+#define INITIAL_FLOOR_HEIGHT W_HEIGHT * 0.3
+#define INITIAL_FLOOR_Y W_HEIGHT - INITIAL_FLOOR_HEIGHT
+#define PLAYER_WIDTH W_WIDTH / 15
+#define PLAYER_HEIGHT W_HEIGHT / 15
+#define PLAYER_SPEED 2.5
+#define PLAYER_SCREEN_X ((W_WIDTH - PLAYER_WIDTH) / 2)
+
+#define JUMP_DILATION 0.01
+#define HALF_JUMP_WIDTH PLAYER_HEIGHT * 3
+#define JUMP_SPEED 2.5
+#define ARC_TABLE_SIZE 512
+
+// A jump that can't be taken when it is pressed stays buffered this many ticks before it is dropped.
+#define JUMP_BUFFER_TICKS 8
+
+#define NUM_OBSTACLES 50
+#define STREAM_AHEAD (W_WIDTH * 2)
+#define COLLISION_WINDOW 8
+// The screen is five obstacle spacings wide, so no more than six obstacles are ever on it at once.
+#define MAX_VISIBLE_OBSTACLES 8
+#define OBSTACLE_WIDTH W_WIDTH / 10
+#define XTEND_OBSTACLE_WIDTH W_WIDTH / 2
+#define OBSTACLE_HEIGHT W_HEIGHT / 8
+#define XTEND_OBSTACLE_HEIGHT W_HEIGHT / 3
+#define HOLE_WIDTH HALF_JUMP_WIDTH * 1.5
+#define XTEND_HOLE_WIDTH HALF_JUMP_WIDTH * 3.5
+#define HOLE_HEIGHT INITIAL_FLOOR_HEIGHT
+#define HOLE_Y INITIAL_FLOOR_Y
+#define OBSTACLE_SPACING W_WIDTH / 5
+#define XTEND_OBSTACLE_SPACING W_WIDTH / 2
+
+#define GAME_OVER_DISPLAY_TIME 5000
+
+#define TRUE 1
+#define FALSE 0
+
+#define TICK_MS 10
+#define TICK_SECONDS (TICK_MS / 1000.0)
+#define DEATH_PAUSE ((GAME_OVER_DISPLAY_TIME / 10) / 1000.0)
+
+#define PLAYER_RUNNING 0
+#define PLAYER_JUMPING 1
+#define PLAYER_FALLING 2
+#define PLAYER_DYING 3
+#define PLAYER_DEAD 4
+
+#define FLOOR_Y INITIAL_FLOOR_Y
+
+#define ASCII_A 65
+#define MAX_LEVEL 25
+
+// Player commands, applied to the game between ticks. Replays store these same values.
+#define COMMAND_JUMP 1
+
+
+/* The state of one game. Everything the simulation reads or writes lives here, so several games can run side by side, e.g. one
+ * per thread in the batch runner. */
+typedef struct {
+	SDL_Rect player;
+	double floor_y;
+	int is_alive;
+	int player_speed;
+	int jump_speed;
+	int hole_collision;
+	int level;
+
+	int player_state;
+	int jump_buffer;
+	double arc_x;
+	double arc_start_y;
+	int dying_speed;
+	double death_timer;
+
+	int camera_x;
+	int prev_camera_x;
+	int prev_player_x;
+	int prev_player_y;
+
+	int obstacle_cursor;
+	int obstacles_passed;
+
+	Uint32 tick;
+} Game;
+
+
+SDL_Rect* get_rect(Arena* arena, int start_coordinate_x, int start_coordinate_y, int width, int height);
+void new_game(Game* game);
+void update(Game* game, Course* course, double dt);
+void game_command(Game* game, int type);
+int can_jump(Game* game);
+void jump(Game* game);
+void fall(Game* game);
+void step_arc(Game* game);
+double arc_drop(double arc_x);
+void sweep_player(Game* game, Course* course, int from_x, int from_y);
+void kill_player(Game* game);
+void screen_scroll(Game* game);
+void colliding_obstacle(Game* game, Course* course);
+void advance_cursor(Game* game, Course* course);
+int visible_obstacles(Game* game, Course* course, int camera, SDL_Rect* blocks, SDL_Rect* holes, int* num_holes);
+void is_within_bounds(Game* game);
+Uint32 game_checksum(Game* game, Course* course);
+
+
+#endif
@@ -0,0 +1,158 @@
+#include <assert.h>
+#include <limits.h>
+#include "ghost.h"
+
+
+static void stop_ghost(GhostRace* race, int i);
+
+
+/* Loads the replays at `paths` into `sources`. They must all be of the same course: the same seed and length. Returns how many
+ * were loaded; fewer than `num_paths` means `paths[returned]` could not be read or is of another course. */
+int
+load_ghost_replays(Replay* sources, const char** paths, int num_paths) {
+
+	int i;
+
+	for (i = 0; i < num_paths; i++) {
+		if (!load_replay(&sources[i], paths[i])) {
+			return i;
+		}
+		if (i > 0 && (sources[i].seed != sources[0].seed || sources[i].course_length != sources[0].course_length)) {
+			free_replay(&sources[i]);
+			return i;
+		}
+	}
+	return num_paths;
+}
+
+
+/* Returns the arena space `new_ghost_race` needs for `count` ghosts on a course of `course_length` obstacles. */
+size_t
+ghost_race_size(int count, int course_length) {
+	return course_size(course_length) + count * (sizeof(Game) + sizeof(Replay) + sizeof(int) + sizeof(SDL_Rect)) +
+		4 * ARENA_ALIGNMENT;
+}
+
+
+/* Sets up a race of `copies` ghosts of each of the `num_sources` replays in `sources`, all at tick 0 of their course, with
+ * storage from `arena` (at least `ghost_race_size` bytes free). Copies share their source's inputs, so a few recordings can fill
+ * a stress test with hundreds of ghosts. The race owns `sources` from here on. */
+void
+new_ghost_race(GhostRace* race, Replay* sources, int num_sources, int copies, Arena* arena) {
+
+	int i;
+
+	assert(num_sources > 0 && num_sources * copies <= MAX_GHOSTS);
+
+	race->count = num_sources * copies;
+	race->games = (Game*)arena_alloc(arena, race->count * sizeof(Game));
+	race->replays = (Replay*)arena_alloc(arena, race->count * sizeof(Replay));
+	race->running = (int*)arena_alloc(arena, race->count * sizeof(int));
+	race->rects = (SDL_Rect*)arena_alloc(arena, race->count * sizeof(SDL_Rect));
+	race->sources = sources;
+	race->num_sources = num_sources;
+	race->num_running = race->count;
+	race->dropped = 0;
+	new_course(&race->course, sources[0].course_length, sources[0].seed, arena);
+
+	for (i = 0; i < race->count; i++) {
+		new_game(&race->games[i]);
+		// A copy shares its source's events and keeps its own playback cursor.
+		race->replays[i] = sources[i % num_sources];
+		race->replays[i].cursor = 0;
+		race->running[i] = TRUE;
+	}
+}
+
+
+/* Advances every running ghost by one tick. A ghost stops at the tick its recording ended on, and is dropped if it trails so far
+ * behind the leader that the course can't stream far enough ahead for the leader. */
+void
+update_ghosts(GhostRace* race, double dt) {
+
+	int i;
+	Game* ghost;
+
+	// Every ghost streams the shared course from its own camera, so the leader's would recycle the obstacles of the ghosts behind
+	// it; the course is held at the trailing running ghost's cursor instead. Cursors only advance, so the hold stays good through
+	// the tick.
+	race->course.hold = INT_MAX;
+	for (i = 0; i < race->count; i++) {
+		if (race->running[i] && race->games[i].obstacle_cursor < race->course.hold) {
+			race->course.hold = race->games[i].obstacle_cursor;
+		}
+	}
+
+	for (i = 0; i < race->count; i++) {
+		ghost = &race->games[i];
+		if (!race->running[i]) {
+			continue;
+		}
+		if (ghost->tick >= race->replays[i].final_tick) {
+			stop_ghost(race, i);
+			continue;
+		}
+		replay_apply(&race->replays[i], ghost);
+		update(ghost, &race->course, dt);
+	}
+
+	// A held course fills its ring, and then the leader finds no new obstacles ahead. The leader generates at most a few
+	// obstacles a tick, so a ghost is dropped, letting the course move on, while the margin still leaves room for the next tick.
+	for (i = 0; i < race->count; i++) {
+		if (race->course.endless && race->running[i] &&
+			race->games[i].obstacle_cursor < race->course.end - race->course.capacity + COLLISION_WINDOW) {
+			stop_ghost(race, i);
+			race->dropped++;
+		}
+	}
+}
+
+
+/* Stops ghost `i` where it is. It stays on the course, drawn still. */
+static void
+stop_ghost(GhostRace* race, int i) {
+	race->running[i] = FALSE;
+	race->num_running--;
+	race->games[i].prev_player_x = race->games[i].player.x;
+	race->games[i].prev_player_y = race->games[i].player.y;
+}
+
+
+/* Fills `race->rects` with the screen rects of the ghosts in view of `camera`, `alpha` (0 to 1) of the way from their previous
+ * tick to their current one, ready to be drawn in one batch. Returns how many there are. */
+int
+ghost_rects(GhostRace* race, int camera, double alpha) {
+
+	int i, n = 0;
+	Game* ghost;
+	SDL_Rect* rect;
+
+	for (i = 0; i < race->count; i++) {
+		ghost = &race->games[i];
+		rect = &race->rects[n];
+		rect->x = ghost->prev_player_x + (int)((ghost->player.x - ghost->prev_player_x) * alpha) - camera;
+		rect->y = ghost->prev_player_y + (int)((ghost->player.y - ghost->prev_player_y) * alpha);
+		rect->w = ghost->player.w;
+		rect->h = ghost->player.h;
+		if (rect->x + rect->w > 0 && rect->x < W_WIDTH) {
+			n++;
+		}
+	}
+	return n;
+}
+
+
+/* Releases the replays the race was built from. The ghosts themselves go back when their arena is reset. */
+void
+free_ghosts(GhostRace* race) {
+
+	int i;
+
+	for (i = 0; i < race->num_sources; i++) {
+		free_replay(&race->sources[i]);
+	}
+	free_course(&race->course);
+	race->count = 0;
+	race->num_running = 0;
+	race->num_sources = 0;
+}
@@ -0,0 +1,40 @@
+#ifndef GHOST_H
+#define GHOST_H
+
+#include "SDL.h"
+#include "game.h"
+#include "replay.h"
+#include "arena.h"
+
+#define MAX_GHOSTS 1024
+
+
+/* Recorded runs raced against the live player. Every ghost is a whole game kept in one contiguous array and fed its replay's
+ * inputs, so all of them advance in one pass per tick. The ghosts share their own copy of the course, built from the same seed
+ * as the live player's, so they never disturb the live game's course (or its replay).
+ *
+ * On an endless course the shared window follows the leading ghost. Obstacles behind it keep their slots until the ring comes
+ * round again, so ghosts trailing the leader by up to about `COURSE_CAPACITY` obstacles still see the course they were recorded
+ * on; a ghost that falls further behind is dropped. */
+typedef struct {
+	Game* games;
+	Replay* replays;
+	int* running;
+	SDL_Rect* rects;
+	int count;
+	int num_running;
+	int dropped;
+	Course course;
+	Replay* sources;
+	int num_sources;
+} GhostRace;
+
+
+int load_ghost_replays(Replay* sources, const char** paths, int num_paths);
+size_t ghost_race_size(int count, int course_length);
+void new_ghost_race(GhostRace* race, Replay* sources, int num_sources, int copies, Arena* arena);
+void update_ghosts(GhostRace* race, double dt);
+int ghost_rects(GhostRace* race, int camera, double alpha);
+void free_ghosts(GhostRace* race);
+
+#endif
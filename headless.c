@@ -0,0 +1,353 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include "SDL.h"
+#include "game.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "ghost.h"
+#include "bot.h"
+
+#define DEFAULT_GAMES 1000
+#define DEFAULT_OBSTACLES NUM_OBSTACLES
+#define DEFAULT_MAX_TICKS 100000
+
+
+int play_replay(const char* path, int realtime, int rewind);
+int race_ghosts(const char** paths, int num_paths, int copies);
+int parse_count(const char* text, long min, long max, long* value);
+void usage(const char* program);
+
+
+/* Plays complete games with no window, renderer, fonts or delays and reports simulation throughput. */
+int
+main(int argc, char* argv[]) {
+
+	int i, games = DEFAULT_GAMES, course_length = DEFAULT_OBSTACLES, policy = POLICY_SCRIPTED, completed, games_completed = 0;
+	long max_ticks = DEFAULT_MAX_TICKS, ticks, total_ticks = 0, value;
+	double seconds;
+	Uint64 start_counter, seed = rng_time_seed();
+	long start_allocations, obstacles = 0, rejected = 0, repaired = 0, unpassable = 0;
+	Uint64 generate_counter = 0, verify_counter = 0;
+	Arena level_arena;
+	Course course;
+	const char* record_path = NULL;
+	const char* replay_path = NULL;
+	int realtime = FALSE, rewind = FALSE, ghosts = 0, num_ghost_paths = 1;
+	const char* ghost_paths[MAX_GHOSTS];
+	Replay recording;
+	Game game;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--games") == 0 && i + 1 < argc && parse_count(argv[++i], 1, INT_MAX, &value)) {
+			games = (int)value;
+		}
+		else if (strcmp(argv[i], "--obstacles") == 0 && i + 1 < argc && parse_count(argv[++i], 1, MAX_COURSE_LENGTH, &value)) {
+			course_length = (int)value;
+		}
+		else if (strcmp(argv[i], "--endless") == 0) {
+			course_length = ENDLESS_COURSE;
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			record_path = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replay_path = argv[++i];
+		}
+		else if (strcmp(argv[i], "--realtime") == 0) {
+			realtime = TRUE;
+		}
+		else if (strcmp(argv[i], "--rewind") == 0) {
+			rewind = TRUE;
+		}
+		else if (strcmp(argv[i], "--ghosts") == 0 && i + 1 < argc && parse_count(argv[++i], 1, MAX_GHOSTS, &value)) {
+			ghosts = (int)value;
+		}
+		else if (strcmp(argv[i], "--ghost") == 0 && i + 1 < argc && num_ghost_paths < MAX_GHOSTS) {
+			ghost_paths[num_ghost_paths++] = argv[++i];
+		}
+		else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc && parse_count(argv[++i], 1, INT_MAX, &value)) {
+			max_ticks = value;
+		}
+		else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+			if ((policy = policy_from_name(argv[++i])) < 0) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		}
+		else {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (replay_path != NULL && (ghosts > 0 || num_ghost_paths > 1)) {
+		ghost_paths[0] = replay_path;
+		return race_ghosts(ghost_paths, num_ghost_paths, (ghosts > 0) ? ghosts : 1);
+	}
+	if (replay_path != NULL) {
+		return play_replay(replay_path, realtime, rewind);
+	}
+
+	// Game `i` plays the course of seed `seed + i`, so a whole run can be repeated from its seed.
+	if (record_path != NULL) {
+		new_replay(&recording, seed, course_length);
+	}
+
+	// Every game's course is built in the same arena, so the games themselves allocate nothing.
+	new_arena(&level_arena, course_size(course_length));
+
+	start_allocations = heap_allocations();
+	start_counter = SDL_GetPerformanceCounter();
+	for (i = 0; i < games; i++) {
+		ticks = play_game(&game, &course, policy, course_length, seed + i, max_ticks, &completed,
+			(i == 0 && record_path != NULL) ? &recording : NULL, &level_arena);
+		total_ticks += ticks;
+		games_completed += completed;
+		obstacles += course.end;
+		rejected += course.rejected;
+		repaired += course.repaired;
+		unpassable += course.unpassable;
+		generate_counter += course.generate_counter;
+		verify_counter += course.verify_counter;
+		free_course(&course);
+	}
+	seconds = (double)(SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency();
+	start_allocations = heap_allocations() - start_allocations;
+	free_arena(&level_arena);
+
+	printf("kernel: %s\n", course_kernel_name());
+	printf("seed: %llu\n", (unsigned long long)seed);
+	printf("policy: %s\n", policy_names[policy]);
+	printf("games: %d\n", games);
+	if (course_length == ENDLESS_COURSE) {
+		printf("obstacles: endless\n");
+	}
+	else {
+		printf("obstacles: %d\n", course_length);
+	}
+	printf("games_completed: %d\n", games_completed);
+	printf("ticks: %ld\n", total_ticks);
+	printf("mean_ticks_per_game: %.1f\n", (games > 0) ? (double)total_ticks / games : 0.0);
+	printf("seconds: %.6f\n", seconds);
+	printf("ticks_per_sec: %.0f\n", (seconds > 0) ? total_ticks / seconds : 0.0);
+	printf("games_per_sec: %.1f\n", (seconds > 0) ? games / seconds : 0.0);
+	printf("allocations: %ld\n", start_allocations);
+	printf("obstacles_generated: %ld\n", obstacles);
+	printf("obstacles_rejected: %ld\n", rejected);
+	printf("obstacles_repaired: %ld\n", repaired);
+	printf("obstacles_unpassable: %ld\n", unpassable);
+	printf("generate_us_per_obstacle: %.3f\n", (obstacles > 0) ? generate_counter * 1e6 / SDL_GetPerformanceFrequency() / obstacles : 0.0);
+	printf("verify_us_per_obstacle: %.3f\n", (obstacles > 0) ? verify_counter * 1e6 / SDL_GetPerformanceFrequency() / obstacles : 0.0);
+
+	if (record_path != NULL) {
+		if (!save_replay(&recording, record_path)) {
+			fprintf(stderr, "could not write replay %s\n", record_path);
+			return EXIT_FAILURE;
+		}
+		printf("recorded: %s (%d inputs, %u ticks)\n", record_path, recording.num_events, recording.final_tick);
+		free_replay(&recording);
+	}
+
+	// A repair is passable by construction, so one that fails its check is a bug in the generator or the verifier.
+	if (unpassable > 0) {
+		fprintf(stderr, "%ld repaired obstacles could not be passed\n", unpassable);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+
+/* Prints command line usage. */
+void
+usage(const char* program) {
+	fprintf(stderr, "usage: %s [--games N] [--obstacles N | --endless] [--seed N] [--max-ticks N] [--policy random|scripted|dawdle]"
+		" [--record FILE]\n", program);
+	fprintf(stderr, "       %s --replay FILE [--realtime | --rewind | [--ghost FILE]... [--ghosts N]]\n", program);
+}
+
+
+/* Reads `text` as a whole decimal number from `min` to `max` into `value`. Returns FALSE if it is anything else, so a typo can't
+ * quietly become 0 (an endless course) or a length no course can hold. */
+int
+parse_count(const char* text, long min, long max, long* value) {
+
+	char* end;
+
+	errno = 0;
+	*value = strtol(text, &end, 10);
+	return end != text && *end == '\0' && errno == 0 && *value >= min && *value <= max;
+}
+
+
+/* Plays back a recorded game, as fast as possible or at the game's own tick rate when `realtime` is set, and checks that it ends
+ * in the recorded state. With `rewind`, a snapshot is taken every tick; at the end the game is rewound to the oldest one held and
+ * played forward again, and must end in the recorded state both times. Returns `EXIT_FAILURE` if the replay can't be read or a
+ * checksum does not match. */
+int
+play_replay(const char* path, int realtime, int rewind) {
+
+	Replay replay;
+	Game game;
+	Course course;
+	Arena level_arena;
+	SnapshotRing ring;
+	Uint32 checksum, rewound_checksum = 0, rewind_tick = 0;
+	Uint64 start_counter, snapshot_counter = 0, restore_counter = 0;
+	double seconds;
+	int i, ok;
+
+	if (!load_replay(&replay, path)) {
+		fprintf(stderr, "could not read replay %s\n", path);
+		return EXIT_FAILURE;
+	}
+
+	new_arena(&level_arena, course_size(replay.course_length) + (rewind ? snapshot_ring_size(SNAPSHOT_RING_SIZE) : 0));
+	new_course(&course, replay.course_length, replay.seed, &level_arena);
+	if (rewind) {
+		new_snapshot_ring(&ring, SNAPSHOT_RING_SIZE, &level_arena);
+	}
+	new_game(&game);
+
+	start_counter = SDL_GetPerformanceCounter();
+	while (game.tick < replay.final_tick) {
+		if (rewind) {
+			Uint64 snapshot_start = SDL_GetPerformanceCounter();
+			push_snapshot(&ring, &game, &course);
+			snapshot_counter += SDL_GetPerformanceCounter() - snapshot_start;
+		}
+		replay_apply(&replay, &game);
+		update(&game, &course, TICK_SECONDS);
+
+		// Sleeps until the wall clock catches up with the simulation.
+		while (realtime && (double)(SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency() <
+			game.tick * TICK_SECONDS) {
+			SDL_Delay(1);
+		}
+	}
+	seconds = (double)(SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency();
+	checksum = game_checksum(&game, &course);
+	ok = (checksum == replay.checksum);
+
+	if (rewind && ring.end > ring.first) {
+		// Restoring the newest snapshot over and over measures the common case, where the course window is still in its slots.
+		for (i = 0; i < SNAPSHOT_RING_SIZE; i++) {
+			Uint64 restore_start = SDL_GetPerformanceCounter();
+			restore_snapshot(&ring.snapshots[(ring.end - 1) & ring.mask], &game, &course);
+			restore_counter += SDL_GetPerformanceCounter() - restore_start;
+		}
+
+		rewind_tick = ring.snapshots[ring.first & ring.mask].game.tick;
+		rewind_to(&ring, rewind_tick, &game, &course);
+		replay_seek(&replay, game.tick);
+		while (game.tick < replay.final_tick) {
+			replay_apply(&replay, &game);
+			update(&game, &course, TICK_SECONDS);
+		}
+		rewound_checksum = game_checksum(&game, &course);
+		ok = ok && (rewound_checksum == replay.checksum);
+	}
+
+	printf("replay: %s\n", path);
+	printf("seed: %llu\n", (unsigned long long)replay.seed);
+	printf("inputs: %d\n", replay.num_events);
+	printf("ticks: %u\n", replay.final_tick);
+	printf("seconds: %.6f\n", seconds);
+	printf("ticks_per_sec: %.0f\n", (seconds > 0) ? replay.final_tick / seconds : 0.0);
+	printf("checksum: %08x (recorded %08x)\n", checksum, replay.checksum);
+	if (rewind) {
+		printf("snapshot_bytes: %d\n", (int)sizeof(Snapshot));
+		printf("snapshot_ns: %.1f\n", (replay.final_tick > 0) ?
+			snapshot_counter * 1e9 / SDL_GetPerformanceFrequency() / replay.final_tick : 0.0);
+		printf("restore_ns: %.1f\n", restore_counter * 1e9 / SDL_GetPerformanceFrequency() / SNAPSHOT_RING_SIZE);
+		printf("rewound_to_tick: %u\n", rewind_tick);
+		printf("rewound_checksum: %08x\n", rewound_checksum);
+	}
+	printf("result: %s\n", ok ? "ok" : "mismatch");
+
+	free_course(&course);
+	free_arena(&level_arena);
+	free_replay(&replay);
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/* Races `copies` ghosts of each of the replays at `paths`, all of one course, stepped together on one shared course, and reports
+ * how fast the ghosts are simulated. A ghost that runs to the end of its recording must end in the same state as its replay
+ * played alone, however far ahead of or behind the others it was. Returns `EXIT_FAILURE` if a replay can't be read or any
+ * ghost's state does not match. */
+int
+race_ghosts(const char** paths, int num_paths, int copies) {
+
+	Replay sources[MAX_GHOSTS];
+	Replay alone;
+	Game game;
+	GhostRace race;
+	Course* courses;
+	Arena level_arena;
+	Uint64 start_counter;
+	double seconds;
+	long ghost_ticks = 0;
+	int i, mismatched = 0;
+
+	if (num_paths * copies > MAX_GHOSTS) {
+		copies = MAX_GHOSTS / num_paths;
+	}
+	if ((i = load_ghost_replays(sources, paths, num_paths)) != num_paths) {
+		fprintf(stderr, "could not read replay %s, or it is of another course\n", paths[i]);
+		return EXIT_FAILURE;
+	}
+
+	new_arena(&level_arena, ghost_race_size(num_paths * copies, sources[0].course_length) +
+		num_paths * (course_size(sources[0].course_length) + sizeof(Course)) + ARENA_ALIGNMENT);
+	new_ghost_race(&race, sources, num_paths, copies, &level_arena);
+
+	start_counter = SDL_GetPerformanceCounter();
+	while (race.num_running > 0) {
+		ghost_ticks += race.num_running;
+		update_ghosts(&race, TICK_SECONDS);
+	}
+	seconds = (double)(SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency();
+
+	// Each recording is played again alone, and its ghosts are checked against the course as it stood at its end. That is the
+	// recorded checksum when the ghost's state matches.
+	courses = (Course*)arena_alloc(&level_arena, num_paths * sizeof(Course));
+	for (i = 0; i < num_paths; i++) {
+		alone = sources[i];
+		alone.cursor = 0;
+		new_course(&courses[i], alone.course_length, alone.seed, &level_arena);
+		new_game(&game);
+		while (game.tick < alone.final_tick) {
+			replay_apply(&alone, &game);
+			update(&game, &courses[i], TICK_SECONDS);
+		}
+	}
+	for (i = 0; i < race.count; i++) {
+		if (race.games[i].tick >= race.replays[i].final_tick) {
+			mismatched += (game_checksum(&race.games[i], &courses[i % num_paths]) != race.replays[i].checksum);
+		}
+	}
+
+	printf("replay: %s\n", paths[0]);
+	printf("replays: %d\n", num_paths);
+	printf("ghosts: %d\n", race.count);
+	printf("ticks: %u\n", sources[0].final_tick);
+	printf("seconds: %.6f\n", seconds);
+	printf("ghost_ticks_per_sec: %.0f\n", (seconds > 0) ? ghost_ticks / seconds : 0.0);
+	printf("race_ticks_per_sec: %.0f\n", (seconds > 0) ? sources[0].final_tick / seconds : 0.0);
+	printf("dropped: %d\n", race.dropped);
+	printf("mismatched: %d\n", mismatched);
+	printf("result: %s\n", (mismatched == 0) ? "ok" : "mismatch");
+
+	for (i = 0; i < num_paths; i++) {
+		free_course(&courses[i]);
+	}
+	free_ghosts(&race);
+	free_arena(&level_arena);
+	return (mismatched == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
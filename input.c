@@ -0,0 +1,148 @@
+#include "input.h"
+
+
+Uint32 latency_histogram[LATENCY_BUCKETS];
+double latency_max_us = 0;
+long latencies_measured = 0;
+
+
+/* Empties a command queue. */
+void
+new_command_queue(CommandQueue* queue) {
+	queue->head = 0;
+	queue->count = 0;
+	queue->dropped = 0;
+	queue->pending_since = 0;
+}
+
+
+/* Queues a command for tick `tick`. `timestamp` is the performance counter reading of when the input happened. */
+void
+push_command(CommandQueue* queue, Uint32 tick, int type, Uint64 timestamp) {
+
+	Command* command;
+
+	if (queue->count == COMMAND_QUEUE_SIZE) {
+		queue->dropped++;
+		return;
+	}
+	command = &queue->commands[(queue->head + queue->count) % COMMAND_QUEUE_SIZE];
+	command->tick = tick;
+	command->type = (Uint8)type;
+	command->timestamp = timestamp;
+	queue->count++;
+}
+
+
+/* Applies every queued command due at the game's current tick, recording each to `recording` unless it is NULL. Call once per
+ * tick, just before the update. Returns the number of commands applied. */
+int
+apply_commands(CommandQueue* queue, Game* game, Replay* recording) {
+
+	int applied = 0;
+	Command* command;
+
+	while (queue->count > 0 && queue->commands[queue->head].tick <= game->tick) {
+		command = &queue->commands[queue->head];
+		game_command(game, command->type);
+		if (recording != NULL) {
+			replay_record(recording, game->tick, command->type);
+		}
+		// Only the oldest input not yet on screen is timed; later ones show up in the same frame.
+		if (queue->pending_since == 0) {
+			queue->pending_since = command->timestamp;
+		}
+		queue->head = (queue->head + 1) % COMMAND_QUEUE_SIZE;
+		queue->count--;
+		applied++;
+	}
+	return applied;
+}
+
+
+/* Converts an SDL event timestamp (milliseconds since SDL started) to a performance counter reading, so the time an event spent
+ * waiting to be polled counts towards its latency. */
+Uint64
+event_timestamp(Uint32 event_ms) {
+
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint32 waited_ms = SDL_GetTicks() - event_ms;
+
+	// Events stamped in the future (the two clocks tick separately) or long ago (a stalled window) are taken as just polled.
+	if (waited_ms > 1000) {
+		return now;
+	}
+	return now - (Uint64)waited_ms * SDL_GetPerformanceFrequency() / 1000;
+}
+
+
+/* Called once a frame has been presented at `present_counter`: the first frame after an input was applied is the first one that
+ * can show it, so that is where its latency ends. */
+void
+input_presented(CommandQueue* queue, Uint64 present_counter) {
+
+	int bucket;
+	double us;
+
+	if (queue->pending_since == 0) {
+		return;
+	}
+	us = (present_counter > queue->pending_since) ?
+		(double)(present_counter - queue->pending_since) * 1000000.0 / SDL_GetPerformanceFrequency() : 0;
+	bucket = (int)(us / LATENCY_BUCKET_US);
+	latency_histogram[(bucket < LATENCY_BUCKETS) ? bucket : (LATENCY_BUCKETS - 1)]++;
+	if (us > latency_max_us) {
+		latency_max_us = us;
+	}
+	latencies_measured++;
+	queue->pending_since = 0;
+}
+
+
+/* Clears the latency statistics. */
+void
+latency_reset(void) {
+
+	int i;
+
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		latency_histogram[i] = 0;
+	}
+	latency_max_us = 0;
+	latencies_measured = 0;
+}
+
+
+/* Returns the latency in milliseconds that `fraction` (0 to 1) of the measured inputs took at most, to the histogram's
+ * resolution. */
+double
+latency_percentile(double fraction) {
+
+	int i;
+	long seen = 0, target = (long)(fraction * latencies_measured);
+
+	if (latencies_measured == 0) {
+		return 0;
+	}
+	for (i = 0; i < LATENCY_BUCKETS - 1; i++) {
+		seen += latency_histogram[i];
+		if (seen > target) {
+			break;
+		}
+	}
+	return ((i + 1) * LATENCY_BUCKET_US < latency_max_us) ? ((i + 1) * LATENCY_BUCKET_US / 1000.0) : latency_max();
+}
+
+
+/* Returns the longest latency measured, in milliseconds. */
+double
+latency_max(void) {
+	return latency_max_us / 1000.0;
+}
+
+
+/* Returns the number of inputs whose latency was measured. */
+long
+latency_count(void) {
+	return latencies_measured;
+}
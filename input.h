@@ -0,0 +1,44 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "SDL.h"
+#include "game.h"
+#include "replay.h"
+
+#define COMMAND_QUEUE_SIZE 64
+
+// Key-down to present latencies are kept in a histogram with `LATENCY_BUCKET_US` resolution up to `LATENCY_BUCKETS` buckets.
+#define LATENCY_BUCKET_US 100
+#define LATENCY_BUCKETS 2000
+
+
+/* One player input: what it is, the tick it is applied on and the performance counter reading of when the key went down. */
+typedef struct {
+	Uint32 tick;
+	Uint8 type;
+	Uint64 timestamp;
+} Command;
+
+
+/* Commands waiting for the simulation, in the order they arrived. Inputs that arrive between ticks wait here for the next tick;
+ * if the queue is full they are dropped and counted. */
+typedef struct {
+	Command commands[COMMAND_QUEUE_SIZE];
+	int head;
+	int count;
+	long dropped;
+	Uint64 pending_since;
+} CommandQueue;
+
+
+void new_command_queue(CommandQueue* queue);
+void push_command(CommandQueue* queue, Uint32 tick, int type, Uint64 timestamp);
+int apply_commands(CommandQueue* queue, Game* game, Replay* recording);
+Uint64 event_timestamp(Uint32 event_ms);
+void input_presented(CommandQueue* queue, Uint64 present_counter);
+void latency_reset(void);
+double latency_percentile(double fraction);
+double latency_max(void);
+long latency_count(void);
+
+#endif
@@ -1,128 +1,255 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
-#include <math.h>
 #include <string.h>
+#include <ctype.h>
 #include "SDL.h"
 #include "SDL_timer.h"
 #include "SDL_image.h"
 #include "SDL_ttf.h"
+#include "game.h"
+#include "replay.h"
+#include "profile.h"
+#include "pacing.h"
+#include "input.h"
+#include "atlas.h"
+#include "ghost.h"
+#include "playrender.h"
+
+#define MAX_FRAME_TIME 0.25
 
-#define W_HEIGHT 600
-#define W_WIDTH (W_HEIGHT + (W_HEIGHT * 0.5))
-#define TITLE_SIZE W_HEIGHT / 7.5
-#define INSTRUCTION_SIZE TITLE_SIZE / 2
-#define FONT "res/yoster.ttf"
-
-#define TITLE "SQUARE JUMP"
-#define STR_INSTRUCTION_1 "S TO START"
-#define STR_INSTRUCTION_2 "SPACE TO JUMP FORWARD"
-#define STR_INSTRUCTION_3 "RIGHT ARROW KEY TO MOVE FORWARD"
-
-#define INITIAL_FLOOR_HEIGHT W_HEIGHT * 0.3
-#define INITIAL_FLOOR_Y W_HEIGHT - INITIAL_FLOOR_HEIGHT
-#define PLAYER_WIDTH W_WIDTH / 15
-#define PLAYER_HEIGHT W_HEIGHT / 15
-#define PLAYER_SPEED 2.5
-
-#define JUMP_DILATION 0.01
-#define HALF_JUMP_WIDTH PLAYER_HEIGHT * 3
-#define JUMP_SPEED 2.5
-
-#define NUM_OBSTACLES 50
-#define OBSTACLE_WIDTH W_WIDTH / 10
-#define XTEND_OBSTACLE_WIDTH W_WIDTH / 2
-#define OBSTACLE_HEIGHT W_HEIGHT / 8
-#define XTEND_OBSTACLE_HEIGHT W_HEIGHT / 3
-#define HOLE_WIDTH HALF_JUMP_WIDTH * 1.5
-#define XTEND_HOLE_WIDTH HALF_JUMP_WIDTH * 3.5
-#define HOLE_HEIGHT INITIAL_FLOOR_HEIGHT
-#define HOLE_Y INITIAL_FLOOR_Y
-#define OBSTACLE_SPACING W_WIDTH / 5
-#define XTEND_OBSTACLE_SPACING W_WIDTH / 2
-
-#define GAME_OVER "GAME OVER"
-#define GAME_OVER_DISPLAY_TIME 5000
-
-#define TRUE 1
-#define FALSE 0
-
-#define DELAY_FACTOR 10
-
-#define FLOOR_Y INITIAL_FLOOR_Y
-
-#define LEVEL "LEVEL"
 #define LEVEL_DIGITS 2
-#define LEVEL_SIZE 24
-#define ASCII_A 65
+#define NUM_LEVEL_GLYPHS 26
+
+#define TEXT_CACHE_SIZE 128
+#define TEXT_KEY_LENGTH 48
+
+// The debug overlay (F3) redraws its numbers a few times a second so they can be read.
+#define OVERLAY_REFRESH_MS 250
+#define OVERLAY_LINES (NUM_PHASES + 3)
+#define OVERLAY_LINE_LENGTH 40
+#define NUM_OVERLAY_GLYPHS 128
+
+// The level arena holds the course and the rects that last the whole game; the frame arena holds rects that last one frame.
+#define LEVEL_ARENA_RECTS 8
+#define FRAME_ARENA_SIZE 4096
+
+// `--fps` defaults to the display's refresh rate.
+#define DEFAULT_FPS -1
+
+
+/* One of the game's fonts. Its TTF font is only opened if some text wasn't baked into the atlas. */
+typedef struct {
+	int id;
+	TTF_Font* ttf;
+} Font;
+
+
+/* A string rasterized once and kept as a texture, keyed by the font, text and colour it was rendered with. Baked text is a
+ * `source` rect of the shared atlas texture. */
+typedef struct {
+	Font* font;
+	char text[TEXT_KEY_LENGTH];
+	SDL_Colour colour;
+	SDL_Texture* texture;
+	SDL_Rect source;
+	int baked;
+	int width;
+	int height;
+} TextTexture;
+
+
+Font fonts[NUM_FONTS];
+void* font_data = NULL;
+size_t font_data_size = 0;
+int fonts_opened = 0;
 
+// All baked text is one texture, in the colour it was loaded with. `--no-atlas` renders everything live instead.
+SDL_Texture* atlas_texture = NULL;
+SDL_Colour atlas_colour;
+int use_atlas = TRUE;
 
-double floor_y = INITIAL_FLOOR_Y;
-int is_alive = TRUE;
-int player_speed = PLAYER_SPEED;
-int jump_speed = JUMP_SPEED;
-int hole_collision = FALSE;
-double fall_width_x = 0;
-int level = ASCII_A;
+TextTexture text_cache[TEXT_CACHE_SIZE];
+int text_cache_count = 0;
 
+TextTexture* hud_label = NULL;
+TextTexture* hud_level = NULL;
+TextTexture* hud_level_glyphs[NUM_LEVEL_GLYPHS];
+int hud_cached_level = 0;
 
-void render_pre_play(SDL_Renderer* renderer, SDL_Rect* bg_rect, TTF_Font* title_font, TTF_Font* message_font, SDL_Colour font_colour,
+int show_overlay = FALSE;
+char overlay_lines[OVERLAY_LINES][OVERLAY_LINE_LENGTH];
+Uint32 overlay_refreshed_at = 0;
+TextTexture* overlay_glyphs[NUM_OVERLAY_GLYPHS];
+
+CommandQueue input_queue;
+
+Arena level_arena;
+Arena frame_arena;
+Replay replay;
+long frame_allocations = 0;
+
+// `--ghost FILE` races the live player against recorded runs of the same course.
+GhostRace ghosts;
+Replay ghost_sources[MAX_GHOSTS];
+
+
+void render_pre_play(SDL_Renderer* renderer, SDL_Rect* bg_rect, Font* title_font, Font* message_font, SDL_Colour font_colour,
 	SDL_Colour bg_colour);
-SDL_Rect* get_rect(int start_coordinate_x, int start_coordinate_y, int width, int height);
-void render_in_play(SDL_Renderer* renderer, SDL_Rect* bg_rect, SDL_Rect* player_rect, SDL_Rect* floor_rect, SDL_Colour bg_colour, SDL_Colour player_colour,
-	SDL_Colour floor_colour, SDL_Rect** obstacles, TTF_Font* title_font, SDL_Colour font_colour);
-void jump(SDL_Renderer* renderer, SDL_Rect* bg_rect, SDL_Rect* player_rect, SDL_Rect* floor_rect, SDL_Colour bg_colour, SDL_Colour player_colour,
-	SDL_Colour floor_colour, SDL_Rect** obstacles, SDL_Event event, SDL_Window* window, TTF_Font* title_font, SDL_Colour font_colour);
-SDL_Rect** get_obstacles(void);
-void shift_obstacles(SDL_Rect* player_rect, SDL_Rect** obstacles, int shift);
-void screen_scroll(SDL_Rect* player_rect, SDL_Rect* floor_rect, SDL_Rect** obstacles, int is_jump, int is_auto, SDL_Renderer* renderer,
-	SDL_Colour player_colour);
-void colliding_obstacle(SDL_Rect** obstacles, SDL_Renderer* renderer, SDL_Rect* bg_rect, SDL_Rect* player_rect, SDL_Rect* floor_rect,
-	SDL_Colour bg_colour, SDL_Colour player_colour, SDL_Colour floor_colour, SDL_Event event, TTF_Font* title_font, SDL_Colour font_colour);
-void loss(SDL_Renderer* renderer, SDL_Colour bg_colour, SDL_Colour font_colour, TTF_Font* title_font);
-double fall(SDL_Renderer* renderer, SDL_Rect* bg_rect, SDL_Rect* player_rect, SDL_Rect* floor_rect, SDL_Colour bg_colour, SDL_Colour player_colour,
-	SDL_Colour floor_colour, SDL_Rect** obstacles, SDL_Event event, SDL_Window* window, TTF_Font* title_font, SDL_Colour font_colour);
-void is_within_bounds(SDL_Rect* player_rect);
+void render_in_play(SDL_Renderer* renderer, Game* game, SDL_Rect* bg_rect, SDL_Rect* player_rect, SDL_Rect* floor_rect, SDL_Colour bg_colour,
+	SDL_Colour player_colour, SDL_Colour floor_colour, Course* course, int camera_offset, Font* title_font, SDL_Colour font_colour,
+	SDL_Colour ghost_colour, int num_ghosts);
+void render(SDL_Renderer* renderer, Game* game, SDL_Rect* bg_rect, SDL_Rect* floor_rect, SDL_Colour bg_colour, SDL_Colour player_colour,
+	SDL_Colour floor_colour, Course* course, Font* level_font, Font* overlay_font, SDL_Colour font_colour, SDL_Colour ghost_colour,
+	double alpha);
+void render_overlay(SDL_Renderer* renderer, Font* overlay_font, SDL_Colour font_colour);
+void loss(SDL_Renderer* renderer, SDL_Colour bg_colour, SDL_Colour font_colour, Font* title_font, Font* message_font,
+	Uint64 seed);
+TextTexture* get_text(SDL_Renderer* renderer, Font* font, const char* text, SDL_Colour colour);
+int draw_glyphs(SDL_Renderer* renderer, Font* font, const char* text, SDL_Colour colour, int x, int y, int draw);
+TTF_Font* font_ttf(Font* font);
+void load_atlas(SDL_Renderer* renderer, SDL_Colour colour);
+void free_text_cache(void);
+void prepare_hud(SDL_Renderer* renderer, Font* level_font, SDL_Colour font_colour);
+void end_replay(Replay* replay, const char* record_path, const char* replay_path, Game* game, Course* course);
+void quit(SDL_Window* window, SDL_Renderer* renderer);
 
 int
 main(int argc, char* argv[]) {
 
-	assert(SDL_Init(SDL_INIT_TIMER || SDL_INIT_VIDEO || SDL_INIT_EVENTS) == 0);
+	// Cold start is timed from here to the first frame of the start screen.
+	Uint64 startup_counter = SDL_GetPerformanceCounter();
+	int started = FALSE;
+
+	count_sdl_allocations();
+	assert(SDL_Init(SDL_INIT_TIMER | SDL_INIT_VIDEO | SDL_INIT_EVENTS) == 0);
 	assert(TTF_Init() == 0);
 
 	SDL_Window* window;
 	SDL_Renderer* renderer;
 
-	SDL_Rect* bg_rect = get_rect(0, 0, W_WIDTH, W_HEIGHT);
-	SDL_Rect* player_rect = get_rect((W_WIDTH - PLAYER_WIDTH) / 2, floor_y - PLAYER_HEIGHT,
-		PLAYER_WIDTH, PLAYER_HEIGHT);
-	SDL_Rect* floor_rect = get_rect(0, floor_y, W_WIDTH, INITIAL_FLOOR_HEIGHT);
-
-	TTF_Font* title_font = TTF_OpenFont(FONT, TITLE_SIZE);
-	TTF_Font* level_font = TTF_OpenFont(FONT, LEVEL_SIZE);
-	TTF_Font* message_font = TTF_OpenFont(FONT, INSTRUCTION_SIZE);
+	// Fonts are only opened if text is missing from the atlas; see `font_ttf`.
+	int font_id;
+	for (font_id = 0; font_id < NUM_FONTS; font_id++) {
+		fonts[font_id].id = font_id;
+		fonts[font_id].ttf = NULL;
+	}
+	Font* title_font = &fonts[FONT_TITLE];
+	Font* level_font = &fonts[FONT_LEVEL];
+	Font* message_font = &fonts[FONT_MESSAGE];
+	Font* overlay_font = &fonts[FONT_OVERLAY];
 
 	SDL_Colour bg_colour = { 0, 0, 0 };
 	SDL_Colour font_colour = { 0, 255, 0 };
 	SDL_Colour player_colour = { 0, 255, 0 };
+	SDL_Colour ghost_colour = { 0, 96, 0 };
 	SDL_Colour floor_colour = { 0, 0, 255 };
 
 	SDL_Event event;
 
 	int s_was_pressed = FALSE;
-	int was_pre_play_rendered = FALSE;
 
-	SDL_Rect** obstacles = get_obstacles();
+	// `--seed N` replays the course of an earlier game; its seed is shown on the game over screen. `--record FILE` saves the game's
+	// inputs and `--replay FILE` plays a saved game back in real time instead of reading the keyboard. `--fps N` caps the frame rate
+	// (0 for no cap) and `--no-vsync` presents without waiting for the display. `--no-atlas` renders text live instead of from the
+	// baked atlas, to compare start up times. `--ghost FILE`, repeated for up to `MAX_GHOSTS` recordings of one course, races
+	// them as ghosts on that course.
+	Uint64 seed = rng_time_seed();
+	const char* record_path = NULL;
+	const char* replay_path = NULL;
+	const char* trace_path = NULL;
+	const char* ghost_paths[MAX_GHOSTS];
+	int num_ghost_paths = 0;
+	int i, course_length = ENDLESS_COURSE, fps = DEFAULT_FPS, vsync = TRUE;
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			record_path = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replay_path = argv[++i];
+		}
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+			trace_path = argv[++i];
+		}
+		else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+			fps = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--no-vsync") == 0) {
+			vsync = FALSE;
+		}
+		else if (strcmp(argv[i], "--no-atlas") == 0) {
+			use_atlas = FALSE;
+		}
+		else if (strcmp(argv[i], "--ghost") == 0 && i + 1 < argc && num_ghost_paths < MAX_GHOSTS) {
+			ghost_paths[num_ghost_paths++] = argv[++i];
+		}
+	}
+
+	// Ghosts set the course, unless a replay does; then they must be of its course.
+	if (num_ghost_paths > 0) {
+		if ((i = load_ghost_replays(ghost_sources, ghost_paths, num_ghost_paths)) < num_ghost_paths) {
+			fprintf(stderr, "could not read ghost %s, or it is of another course\n", ghost_paths[i]);
+			exit(EXIT_FAILURE);
+		}
+		seed = ghost_sources[0].seed;
+		course_length = ghost_sources[0].course_length;
+	}
+
+	if (replay_path != NULL) {
+		if (!load_replay(&replay, replay_path)) {
+			fprintf(stderr, "could not read replay %s\n", replay_path);
+			exit(EXIT_FAILURE);
+		}
+		if (num_ghost_paths > 0 && (replay.seed != seed || replay.course_length != course_length)) {
+			fprintf(stderr, "ghosts must be replays of the course of %s\n", replay_path);
+			exit(EXIT_FAILURE);
+		}
+		seed = replay.seed;
+		course_length = replay.course_length;
+	}
+	else {
+		new_replay(&replay, seed, course_length);
+	}
+
+	// Everything the game itself needs is allocated here; play only takes memory from the arenas.
+	new_arena(&level_arena, course_size(course_length) + LEVEL_ARENA_RECTS * ARENA_ALIGNMENT +
+		((num_ghost_paths > 0) ? ghost_race_size(num_ghost_paths, course_length) : 0));
+	new_arena(&frame_arena, FRAME_ARENA_SIZE);
+
+	SDL_Rect* bg_rect = get_rect(&level_arena, 0, 0, W_WIDTH, W_HEIGHT);
+	SDL_Rect* floor_rect = get_rect(&level_arena, 0, INITIAL_FLOOR_Y, W_WIDTH, INITIAL_FLOOR_HEIGHT);
+
+	Course course;
+	Game game;
+	new_course(&course, course_length, seed, &level_arena);
+	new_game(&game);
+	ghosts.count = 0;
+	ghosts.num_sources = 0;
+	if (num_ghost_paths > 0) {
+		new_ghost_race(&ghosts, ghost_sources, num_ghost_paths, 1, &level_arena);
+	}
 
 	assert((window = SDL_CreateWindow(TITLE, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, W_WIDTH, W_HEIGHT, 0)) != NULL);
-	assert((renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED || SDL_RENDERER_PRESENTVSYNC)) != NULL);
+	renderer = create_renderer(window, vsync, fps);
+
+	if (use_atlas) {
+		load_atlas(renderer, font_colour);
+	}
+	prepare_hud(renderer, level_font, font_colour);
+	prepare_layers(renderer);
 
 
-	// Renders pre-game screen while `S` has not been pressed.
+	// Renders pre-game screen while `S` has not been pressed. The screen is paced like play so that waiting does not spin the CPU.
 	while (!s_was_pressed) {
-		if (!was_pre_play_rendered) {
-			render_pre_play(renderer, bg_rect, title_font, message_font, font_colour, bg_colour);
-			was_pre_play_rendered = TRUE;
+		arena_reset(&frame_arena);
+		render_pre_play(renderer, bg_rect, title_font, message_font, font_colour, bg_colour);
+		if (!started) {
+			printf("startup: %.2f ms (%s text, %d fonts opened)\n", (double)(SDL_GetPerformanceCounter() - startup_counter) * 1000 /
+				SDL_GetPerformanceFrequency(), (atlas_texture != NULL) ? "baked" : "live", fonts_opened);
+			started = TRUE;
 		}
 		while (SDL_PollEvent(&event) != 0) {
 			if (event.type == SDL_KEYDOWN) {
@@ -131,435 +258,522 @@ main(int argc, char* argv[]) {
 				}
 			}
 			else if (event.key.keysym.sym == SDLK_ESCAPE) {
-				SDL_DestroyWindow(window);
+				quit(window, renderer);
 				exit(EXIT_SUCCESS);
 			}
 		}
+		pace_frame(renderer);
 	}
 
 	SDL_RenderClear(renderer);
 
-	// Logic for in-game play.
-	while (is_alive) {
-		render_in_play(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, level_font, font_colour);
-		// Logic for player movement according to key that was pressed
-		while (SDL_PollEvent(&event) != 0) {
-			if (event.type == SDL_KEYDOWN) {
-				if (event.key.keysym.sym == SDLK_SPACE) {
-					jump(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, event, window, level_font, font_colour);
-					is_within_bounds(player_rect);
+	// Logic for in-game play. The simulation advances in fixed `TICK_SECONDS` steps and rendering interpolates between the last two
+	// ticks, so game speed does not depend on how fast frames are presented.
+	Uint64 previous_counter = SDL_GetPerformanceCounter();
+	double accumulator = 0, frame_time;
+
+	// Every frame is timed phase by phase; `--trace FILE` also streams the timings to a CSV file from a background thread. Heap
+	// allocations are counted per frame too: once the first frames have cached their text and SDL has sized its buffers, play
+	// should not allocate at all.
+	Uint64 phase_start;
+	long frame_start_allocations, play_allocations = 0, allocating_frames = 0;
+	profile_enabled = TRUE;
+	profile_reset();
+	latency_reset();
+	new_command_queue(&input_queue);
+	if (trace_path != NULL && !start_trace(trace_path)) {
+		fprintf(stderr, "could not write trace %s\n", trace_path);
+	}
+
+	while (game.player_state != PLAYER_DEAD || game.death_timer > 0) {
+		frame_start_allocations = heap_allocations();
+		arena_reset(&frame_arena);
+
+		Uint64 counter = SDL_GetPerformanceCounter();
+		frame_time = (double)(counter - previous_counter) / SDL_GetPerformanceFrequency();
+		previous_counter = counter;
+
+		// Avoids a spiral of catch-up ticks after a stall (e.g. the window being dragged).
+		if (frame_time > MAX_FRAME_TIME) {
+			frame_time = MAX_FRAME_TIME;
+		}
+		accumulator += frame_time;
+
+		// Input is drained once per tick into the command queue, stamped with the tick it will be applied on and the time the key
+		// went down, so the simulation sees every input on the tick it arrived in however many ticks the frame runs.
+		while (accumulator >= TICK_SECONDS) {
+			phase_start = phase_begin();
+			while (SDL_PollEvent(&event) != 0) {
+				if (event.type == SDL_KEYDOWN) {
+					if (event.key.keysym.sym == SDLK_SPACE && replay_path == NULL) {
+						push_command(&input_queue, game.tick, COMMAND_JUMP, event_timestamp(event.key.timestamp));
+					}
+					else if (event.key.keysym.sym == SDLK_F3) {
+						show_overlay = !show_overlay;
+					}
+					else if (event.key.keysym.sym == SDLK_ESCAPE) {
+						end_replay(&replay, record_path, replay_path, &game, &course);
+						stop_trace();
+						quit(window, renderer);
+						exit(EXIT_SUCCESS);
+					}
 				}
-				else if (event.key.keysym.sym == SDLK_ESCAPE) {
-					SDL_DestroyWindow(window);
-					exit(EXIT_SUCCESS);
+				else if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) {
+					world_layer_dirty = TRUE;
+					hud_layer_dirty = TRUE;
 				}
 			}
+			if (replay_path != NULL) {
+				replay_apply(&replay, &game);
+			}
+			else {
+				apply_commands(&input_queue, &game, &replay);
+			}
+			phase_end(PHASE_INPUT, phase_start);
+
+			phase_start = phase_begin();
+			update(&game, &course, TICK_SECONDS);
+			update_ghosts(&ghosts, TICK_SECONDS);
+			accumulator -= TICK_SECONDS;
+			phase_end(PHASE_UPDATE, phase_start);
+		}
+
+		// A replay stops where the recorded game did, even if that game was quit before the death pause ran out.
+		if (replay_path != NULL && game.tick >= replay.final_tick) {
+			break;
 		}
-		
-		player_rect->x += player_speed;
-		colliding_obstacle(obstacles, renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, event,
-			level_font, font_colour);
-
-		fall_width_x = fall(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, event, window,
-			level_font, font_colour);
-		screen_scroll(player_rect, floor_rect, obstacles, FALSE, FALSE, renderer, player_colour);
-		render_in_play(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, level_font, font_colour);
-			
-		is_within_bounds(player_rect);
-		colliding_obstacle(obstacles, renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, event,
-			level_font, font_colour);
-		fall_width_x = fall(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, event, window,
-			level_font, font_colour);
-		screen_scroll(player_rect, floor_rect, obstacles, FALSE, TRUE, renderer, player_colour);
+
+		render(renderer, &game, bg_rect, floor_rect, bg_colour, player_colour, floor_colour, &course, level_font, overlay_font,
+			font_colour, ghost_colour, accumulator / TICK_SECONDS);
+		input_presented(&input_queue, SDL_GetPerformanceCounter());
+		pace_frame(renderer);
+		profile_frame_end();
+
+		frame_allocations = heap_allocations() - frame_start_allocations;
+		play_allocations += frame_allocations;
+		allocating_frames += (frame_allocations > 0);
+	}
+
+	stop_trace();
+	print_profile(stdout);
+	printf("draw calls per frame: %d (max %d)\n", draw_calls, max_draw_calls);
+	printf("frame pacing: %s\n", pacing_mode());
+	printf("input latency: p50 %.2f ms, p99 %.2f ms, max %.2f ms over %ld inputs (%ld dropped)\n", latency_percentile(0.5),
+		latency_percentile(0.99), latency_max(), latency_count(), input_queue.dropped);
+	printf("heap allocations in play: %ld (in %ld of %ld frames)\n", play_allocations, allocating_frames, profile_frames());
+	printf("obstacles generated: %d (%d rejected, %d repaired), %.3f us each, %.3f us verifying\n", course.end, course.rejected,
+		course.repaired, course.generate_counter * 1e6 / SDL_GetPerformanceFrequency() / course.end,
+		course.verify_counter * 1e6 / SDL_GetPerformanceFrequency() / course.end);
+	if (ghosts.count > 0) {
+		printf("ghosts: %d raced, %d still running, %d dropped\n", ghosts.count, ghosts.num_running, ghosts.dropped);
 	}
+	end_replay(&replay, record_path, replay_path, &game, &course);
 
-	while (!is_alive) {
-		loss(renderer, bg_colour, font_colour, title_font);
+	while (!game.is_alive) {
+		arena_reset(&frame_arena);
+		loss(renderer, bg_colour, font_colour, title_font, message_font, course.seed);
 
 		while (SDL_PollEvent(&event) != 0) {
 			if (event.key.keysym.sym == SDLK_ESCAPE) {
-				SDL_DestroyWindow(window);
+				quit(window, renderer);
 				exit(EXIT_SUCCESS);
 			}
 		}
+		pace_frame(renderer);
 	}
 
+	quit(window, renderer);
 	return 0;
 }
 
 
-/* Bounds checking. */
+/* Releases everything the game set up: cached textures and layers, fonts, the renderer and window, the arenas and the replay. */
 void
-is_within_bounds(SDL_Rect* player_rect) {
-	if (player_rect->x < 0 || player_rect->y < -PLAYER_HEIGHT) {
-		is_alive = FALSE;
+quit(SDL_Window* window, SDL_Renderer* renderer) {
+
+	int i;
+
+	free_text_cache();
+	if (atlas_texture != NULL) {
+		SDL_DestroyTexture(atlas_texture);
+	}
+	free_layers();
+	for (i = 0; i < NUM_FONTS; i++) {
+		if (fonts[i].ttf != NULL) {
+			TTF_CloseFont(fonts[i].ttf);
+		}
 	}
+	if (font_data != NULL) {
+		SDL_free(font_data);
+	}
+	SDL_DestroyRenderer(renderer);
+	SDL_DestroyWindow(window);
+
+	free_replay(&replay);
+	free_ghosts(&ghosts);
+	free_arena(&frame_arena);
+	free_arena(&level_arena);
+
+	TTF_Quit();
+	SDL_Quit();
 }
 
 
-/* Renders loss message. */
+/* Finishes the replay side of a game: saves the recording to `record_path`, or reports whether a game played back from
+ * `replay_path` ended in its recorded state. */
 void
-loss(SDL_Renderer* renderer, SDL_Colour bg_colour, SDL_Colour font_colour, TTF_Font* title_font) {
+end_replay(Replay* replay, const char* record_path, const char* replay_path, Game* game, Course* course) {
+
+	Uint32 checksum = game_checksum(game, course);
+
+	if (replay_path != NULL) {
+		printf("replay %s: %s\n", replay_path, (game->tick == replay->final_tick && checksum == replay->checksum) ? "ok" : "mismatch");
+	}
+	else if (record_path != NULL) {
+		replay_finish(replay, game->tick, checksum);
+		if (!save_replay(replay, record_path)) {
+			fprintf(stderr, "could not write replay %s\n", record_path);
+		}
+	}
+}
+
+
+/* Renders loss message and the seed of the course. The seed is drawn a glyph at a time, so it needs no text rendered live. */
+void
+loss(SDL_Renderer* renderer, SDL_Colour bg_colour, SDL_Colour font_colour, Font* title_font, Font* message_font,
+	Uint64 seed) {
+
+	int seed_width;
+	char str_seed[TEXT_KEY_LENGTH];
+	TextTexture* t_game_over = get_text(renderer, title_font, GAME_OVER, font_colour);
+	TextTexture* t_title = get_text(renderer, title_font, TITLE, font_colour);
 
-	int str_width, str_height;
-	SDL_Surface* s_game_over = TTF_RenderText_Solid(title_font, GAME_OVER, font_colour);
-	SDL_Texture* t_game_over = SDL_CreateTextureFromSurface(renderer, s_game_over);
+	snprintf(str_seed, sizeof(str_seed), SEED_LABEL "%llu", (unsigned long long)seed);
+	seed_width = draw_glyphs(renderer, message_font, str_seed, font_colour, 0, 0, FALSE);
 
-	assert(TTF_SizeText(title_font, TITLE, &str_width, &str_height) == 0);
-	SDL_Rect* title_rect = get_rect((W_WIDTH - str_width) / 2, (W_HEIGHT - str_height) / 2,
-		str_width, str_height);
+	SDL_Rect* title_rect = get_rect(&frame_arena, (W_WIDTH - t_title->width) / 2, (W_HEIGHT - t_title->height) / 2,
+		t_title->width, t_title->height);
 
 	SDL_SetRenderDrawColor(renderer, bg_colour.r, bg_colour.g, bg_colour.b, SDL_ALPHA_OPAQUE);
 	SDL_RenderClear(renderer);
-	SDL_RenderCopy(renderer, t_game_over, NULL, title_rect);
+	SDL_RenderCopy(renderer, t_game_over->texture, &t_game_over->source, title_rect);
+	draw_glyphs(renderer, message_font, str_seed, font_colour, (W_WIDTH - seed_width) / 2, title_rect->y + title_rect->h, TRUE);
 
 	SDL_RenderPresent(renderer);
 }
 
 
-/* Logic for screen scholling. */
+/* Draws in-game play, without presenting it, through `render_play`, which the benchmark times too. The level letter in the HUD
+ * is looked up first, and the HUD layer marked dirty, if the level has changed. */
 void
-screen_scroll(SDL_Rect* player_rect, SDL_Rect* floor_rect, SDL_Rect** obstacles, int is_jump, int is_auto, SDL_Renderer* renderer,
-	SDL_Colour player_colour) {
+render_in_play(SDL_Renderer* renderer, Game* game, SDL_Rect* bg_rect, SDL_Rect* player_rect, SDL_Rect* floor_rect, SDL_Colour bg_colour,
+	SDL_Colour player_colour, SDL_Colour floor_colour, Course* course, int camera_offset, Font* level_font, SDL_Colour font_colour,
+	SDL_Colour ghost_colour, int num_ghosts) {
 
-	double mid = W_WIDTH / 2;
+	char int_level[LEVEL_DIGITS];
 
-	// Screen scrolling triggered by user movement
-	if (!is_auto) {
-		if (is_jump && player_rect->x > mid) {
-			player_rect->x -= jump_speed;
-			shift_obstacles(player_rect, obstacles, jump_speed);
-		}
-		else if (is_jump && player_rect->x < mid) {
-			shift_obstacles(player_rect, obstacles, jump_speed);
-		}
-		else if (player_rect->x > mid) {
-			player_rect->x -= player_speed;
-			shift_obstacles(player_rect, obstacles, player_speed);
+	// The level letter is only looked up again when the level changes. Letters past Z fall back to the cache.
+	if (game->level != hud_cached_level) {
+		if (game->level >= ASCII_A && game->level < ASCII_A + NUM_LEVEL_GLYPHS) {
+			hud_level = hud_level_glyphs[game->level - ASCII_A];
 		}
 		else {
-			shift_obstacles(player_rect, obstacles, player_speed);
+			int_level[0] = (char)game->level;
+			int_level[1] = '\0';
+			hud_level = get_text(renderer, level_font, int_level, font_colour);
 		}
+		hud_level_text.texture = hud_level->texture;
+		hud_level_text.source = hud_level->source;
+		hud_level_text.rect.x = hud_label_text.rect.w + (2 * hud_level->width);
+		hud_level_text.rect.y = hud_label_text.rect.y;
+		hud_level_text.rect.w = hud_level->width;
+		hud_level_text.rect.h = hud_level->height;
+		hud_cached_level = game->level;
+		hud_layer_dirty = TRUE;
 	}
 
-	// Automatic screen scrolling
-	else {
-		player_rect->x -= player_speed / 2;
-		shift_obstacles(player_rect, obstacles, player_speed / 2);
+	render_play(renderer, game, course, camera_offset, bg_rect, floor_rect, player_rect, ghosts.rects, num_ghosts, bg_colour,
+		floor_colour, player_colour, ghost_colour);
+}
+
 
-		SDL_Delay(DELAY_FACTOR);
+/* Renders the game state `alpha` (0 to 1) of the way from the previous tick to the current one. */
+void
+render(SDL_Renderer* renderer, Game* game, SDL_Rect* bg_rect, SDL_Rect* floor_rect, SDL_Colour bg_colour, SDL_Colour player_colour,
+	SDL_Colour floor_colour, Course* course, Font* level_font, Font* overlay_font, SDL_Colour font_colour, SDL_Colour ghost_colour,
+	double alpha) {
+
+	SDL_Rect player = game->player;
+	int camera = game->prev_camera_x + (game->camera_x - game->prev_camera_x) * alpha, num_ghosts;
+	Uint64 phase_start = phase_begin();
+
+	// The player is interpolated in screen space so it does not jitter against the camera.
+	player.x = (game->prev_player_x - game->prev_camera_x) + ((game->player.x - game->camera_x) -
+		(game->prev_player_x - game->prev_camera_x)) * alpha;
+	player.y = game->prev_player_y + (game->player.y - game->prev_player_y) * alpha;
+
+	// Ghosts are interpolated in world space and placed against the live player's camera.
+	num_ghosts = ghost_rects(&ghosts, camera, alpha);
+
+	render_in_play(renderer, game, bg_rect, &player, floor_rect, bg_colour, player_colour, floor_colour, course, camera, level_font, font_colour,
+		ghost_colour, num_ghosts);
+	if (show_overlay) {
+		render_overlay(renderer, overlay_font, font_colour);
 	}
+	phase_end(PHASE_RENDER, phase_start);
+
+	phase_start = phase_begin();
+	SDL_RenderPresent(renderer);
+	phase_end(PHASE_PRESENT, phase_start);
 }
 
 
-/* Detects collision between player and obstacles. Adjusts `floor_y` as necessary. */
+/* Draws the debug overlay: p50, p99 and max time of each frame phase and of input latency, and the draw calls and heap
+ * allocations of the last frame. Text is drawn a glyph at a time from cached glyph textures, so changing numbers never rasterize
+ * new text. The overlay's own glyph copies are left out of the draw call count. */
 void
-colliding_obstacle(SDL_Rect** obstacles, SDL_Renderer* renderer, SDL_Rect* bg_rect, SDL_Rect* player_rect, SDL_Rect* floor_rect,
-	SDL_Colour bg_colour, SDL_Colour player_colour, SDL_Colour floor_colour, SDL_Event event, TTF_Font* level_font, SDL_Colour font_colour) {
-
-	int i, is_colliding_obstacle = FALSE, x = 0, y, player_start_y = player_rect->y, has_jump = FALSE, obstacles_passed = 0;
-	if (is_alive) {
-		for (i = 0; i < NUM_OBSTACLES; i++) {
-			// Case 1: Player is on top of obstacle
-			if ((player_rect->y <= (obstacles[i]->y - PLAYER_HEIGHT)) && (player_rect->x > (obstacles[i]->x - PLAYER_WIDTH)) &&
-				(player_rect->x < (obstacles[i]->x + obstacles[i]->w)) && (obstacles[i]->y != HOLE_Y)) {
-				hole_collision = FALSE;
-				floor_y = obstacles[i]->y;
-				break;
-			}
-			// Case 2: Player collides with obstacle
-			else if ((SDL_HasIntersection(player_rect, obstacles[i]) == SDL_TRUE) && (obstacles[i]->y != HOLE_Y)) {
+render_overlay(SDL_Renderer* renderer, Font* overlay_font, SDL_Colour font_colour) {
 
-				while (player_rect->y < (floor_y - PLAYER_HEIGHT)) {
-					player_rect->y += player_speed;
-					render_in_play(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, level_font, font_colour);
-					SDL_Delay(DELAY_FACTOR);
-				}
-				player_rect->y = floor_y - PLAYER_HEIGHT;
-				is_alive = FALSE;
-				SDL_Delay(GAME_OVER_DISPLAY_TIME / 10);
-				break;
-			}
-			// Case 3: Player collides with hole
-			else if ((player_rect->y >= (HOLE_Y - PLAYER_HEIGHT)) && (player_rect->x > obstacles[i]->x) &&
-				((player_rect->x + PLAYER_WIDTH) < (obstacles[i]->x + obstacles[i]->w)) && (obstacles[i]->y == HOLE_Y)) {
-				hole_collision = TRUE;
-				floor_y = W_HEIGHT + PLAYER_HEIGHT;
-				break;
-			}
-			// Case 4: Player collides with floor
-			else if ((player_rect->y >= (obstacles[i]->y - PLAYER_HEIGHT)) && (SDL_HasIntersection(player_rect, obstacles[i]) == SDL_TRUE)
-				&& ((player_rect->x + PLAYER_WIDTH) >= (obstacles[i]->x + obstacles[i]->w)) && (obstacles[i]->y == HOLE_Y)) {
-				floor_y = W_HEIGHT + PLAYER_HEIGHT;
-				while (player_rect->y < (floor_y - PLAYER_HEIGHT)) {
-					player_rect->y += jump_speed;
-					render_in_play(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, level_font, font_colour);
-					SDL_Delay(DELAY_FACTOR);
-				}
+	int i, line, x, glyph;
+	char str[2] = { 0, 0 };
+	SDL_Rect rect;
+
+	if (SDL_GetTicks() - overlay_refreshed_at >= OVERLAY_REFRESH_MS || overlay_lines[0][0] == '\0') {
+		snprintf(overlay_lines[0], OVERLAY_LINE_LENGTH, "%-10s %6s %6s %6s", "MS", "P50", "P99", "MAX");
+		for (i = 0; i < NUM_PHASES; i++) {
+			snprintf(overlay_lines[i + 1], OVERLAY_LINE_LENGTH, "%-10s %6.2f %6.2f %6.2f", phase_names[i], profile_percentile(i, 0.5),
+				profile_percentile(i, 0.99), profile_max(i));
+		}
+		snprintf(overlay_lines[NUM_PHASES + 1], OVERLAY_LINE_LENGTH, "DRAW CALLS %d ALLOCS %ld", draw_calls, frame_allocations);
+		snprintf(overlay_lines[NUM_PHASES + 2], OVERLAY_LINE_LENGTH, "%-10s %6.2f %6.2f %6.2f", "LATENCY", latency_percentile(0.5),
+			latency_percentile(0.99), latency_max());
+		overlay_refreshed_at = SDL_GetTicks();
+	}
 
-				player_rect->y = floor_y - PLAYER_HEIGHT;
-				is_alive = FALSE;
-				SDL_Delay(GAME_OVER_DISPLAY_TIME / 10);
-				break;
+	rect.y = 0;
+	for (line = 0; line < OVERLAY_LINES; line++) {
+		x = 0;
+		for (i = 0; overlay_lines[line][i] != '\0'; i++) {
+			glyph = toupper((unsigned char)overlay_lines[line][i]);
+			if (glyph >= NUM_OVERLAY_GLYPHS) {
+				continue;
 			}
-			// Cae 5: No collision
-			else {
-				hole_collision = FALSE;
-				floor_y = FLOOR_Y;
+			// Spaces are drawn as the width of a digit, which keeps the columns roughly lined up.
+			if (overlay_glyphs[glyph] == NULL) {
+				str[0] = (glyph == ' ') ? '0' : (char)glyph;
+				overlay_glyphs[glyph] = get_text(renderer, overlay_font, str, font_colour);
 			}
-
-			if (obstacles[i]->x < player_rect->x) {
-				obstacles_passed++;
+			rect.x = x;
+			rect.w = overlay_glyphs[glyph]->width;
+			rect.h = overlay_glyphs[glyph]->height;
+			if (glyph != ' ') {
+				SDL_RenderCopy(renderer, overlay_glyphs[glyph]->texture, &overlay_glyphs[glyph]->source, &rect);
 			}
+			x += rect.w;
 		}
-
-		player_speed = PLAYER_SPEED + (obstacles_passed / 5);
-		jump_speed = JUMP_SPEED + (obstacles_passed / 5);
-		level = ASCII_A + obstacles_passed / 5;
+		rect.y += rect.h;
 	}
 }
 
 
+/* Renders pre-game screen. */
+void
+render_pre_play(SDL_Renderer* renderer, SDL_Rect* bg_rect, Font* title_font, Font* message_font, SDL_Colour font_colour,
+	SDL_Colour bg_colour) {
 
-/* Logic for falling from a jump or obstacle. */
-double
-fall(SDL_Renderer* renderer, SDL_Rect* bg_rect, SDL_Rect* player_rect, SDL_Rect* floor_rect, SDL_Colour bg_colour, SDL_Colour player_colour,
-	SDL_Colour floor_colour, SDL_Rect** obstacles, SDL_Event event, SDL_Window* window, TTF_Font* level_font, SDL_Colour font_colour) {
+	TextTexture* t_title = get_text(renderer, title_font, TITLE, font_colour);
+	SDL_Rect* title_rect = get_rect(&frame_arena, (W_WIDTH - t_title->width) / 2, (W_HEIGHT - t_title->height) / 2, t_title->width,
+		t_title->height);
 
-	double x = (!hole_collision) ? 0 : fall_width_x;
-	double y, player_start_y = player_rect->y;
+	TextTexture* t_instruction_1 = get_text(renderer, message_font, STR_INSTRUCTION_1, font_colour);
+	SDL_Rect* instruction_1_rect = get_rect(&frame_arena, (W_WIDTH - t_instruction_1->width) / 2,
+		(W_HEIGHT - t_title->height) / 2 + t_title->height, t_instruction_1->width, t_instruction_1->height);
 
-	while (is_alive && (player_rect->y < (floor_y - PLAYER_HEIGHT))) {
+	TextTexture* t_instruction_2 = get_text(renderer, message_font, STR_INSTRUCTION_2, font_colour);
+	SDL_Rect* instruction_2_rect = get_rect(&frame_arena, (W_WIDTH - t_instruction_2->width) / 2,
+		instruction_1_rect->y + t_instruction_2->height, t_instruction_2->width, t_instruction_2->height);
 
-		x += jump_speed;
-		y = (!hole_collision) ? -JUMP_DILATION * pow(x, 2) : -JUMP_DILATION * pow(x, 2) + JUMP_DILATION * pow(fall_width_x, 2);
+	SDL_SetRenderDrawColor(renderer, bg_colour.r, bg_colour.g, bg_colour.b, SDL_ALPHA_OPAQUE);
+	SDL_RenderFillRect(renderer, bg_rect);
 
-		colliding_obstacle(obstacles, renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, event, level_font, font_colour);
+	SDL_SetRenderDrawColor(renderer, font_colour.r, font_colour.g, font_colour.b, SDL_ALPHA_OPAQUE);
+	SDL_RenderCopy(renderer, t_title->texture, &t_title->source, title_rect);
+	SDL_RenderCopy(renderer, t_instruction_1->texture, &t_instruction_1->source, instruction_1_rect);
+	SDL_RenderCopy(renderer, t_instruction_2->texture, &t_instruction_2->source, instruction_2_rect);
 
-		player_rect->x += jump_speed;
-		player_rect->y = player_start_y - y;
+	SDL_RenderPresent(renderer);
+}
 
-		screen_scroll(player_rect, floor_rect, obstacles, TRUE, FALSE, renderer, player_colour);
 
-		render_in_play(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, level_font, font_colour);
+/* Returns the cached texture for `text` rendered in `font` and `colour`. Text baked in the same colour comes from the atlas;
+ * anything else is rasterized on first use. */
+TextTexture*
+get_text(SDL_Renderer* renderer, Font* font, const char* text, SDL_Colour colour) {
 
-		while (SDL_PollEvent(&event) != 0) {
-			if (event.type == SDL_KEYDOWN) {
-				if (event.key.keysym.sym == SDLK_SPACE) {
-					jump(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, event, window, level_font, font_colour);
-					return x;
-				}
-				else if (event.key.keysym.sym == SDLK_ESCAPE) {
-					SDL_DestroyWindow(window);
-					exit(EXIT_SUCCESS);
-				}
-			}
+	int i;
+	TextTexture* entry;
+	const AtlasEntry* baked;
+	SDL_Surface* surface;
+	Uint64 phase_start;
+
+	for (i = 0; i < text_cache_count; i++) {
+		entry = &text_cache[i];
+		if (entry->font == font && entry->colour.r == colour.r && entry->colour.g == colour.g && entry->colour.b == colour.b &&
+			entry->colour.a == colour.a && strcmp(entry->text, text) == 0) {
+			return entry;
 		}
-
-		SDL_Delay(DELAY_FACTOR);
 	}
 
-	if (hole_collision && (player_rect->y >= (floor_y - PLAYER_HEIGHT))) {
-		is_alive = FALSE;
-		return x;
-	}
-	else {
-		player_rect->y = floor_y - PLAYER_HEIGHT;
-		return x;
+	assert(text_cache_count < TEXT_CACHE_SIZE);
+	assert(strlen(text) < TEXT_KEY_LENGTH);
+
+	entry = &text_cache[text_cache_count++];
+	entry->font = font;
+	strcpy(entry->text, text);
+	entry->colour = colour;
+
+	if (atlas_texture != NULL && colour.r == atlas_colour.r && colour.g == atlas_colour.g && colour.b == atlas_colour.b &&
+		colour.a == atlas_colour.a && (baked = atlas_find(font->id, text)) != NULL) {
+		entry->texture = atlas_texture;
+		entry->source.x = baked->x;
+		entry->source.y = baked->y;
+		entry->source.w = baked->w;
+		entry->source.h = baked->h;
+		entry->baked = TRUE;
+		entry->width = baked->w;
+		entry->height = baked->h;
+		return entry;
 	}
-}
-
 
-/* Logic for jumping. */
-void
-jump(SDL_Renderer* renderer, SDL_Rect* bg_rect, SDL_Rect* player_rect, SDL_Rect* floor_rect, SDL_Colour bg_colour, SDL_Colour player_colour,
-	SDL_Colour floor_colour, SDL_Rect** obstacles, SDL_Event event, SDL_Window* window, TTF_Font* level_font, SDL_Colour font_colour) {
-
-	double x = -HALF_JUMP_WIDTH, y, player_start_y = player_rect->y;
+	phase_start = phase_begin();
+	assert((surface = TTF_RenderText_Solid(font_ttf(font), text, colour)) != NULL);
+	assert((entry->texture = SDL_CreateTextureFromSurface(renderer, surface)) != NULL);
+	entry->source.x = 0;
+	entry->source.y = 0;
+	entry->source.w = surface->w;
+	entry->source.h = surface->h;
+	entry->baked = FALSE;
+	SDL_FreeSurface(surface);
+	assert(TTF_SizeText(font_ttf(font), text, &entry->width, &entry->height) == 0);
+	phase_end(PHASE_TEXT, phase_start);
+
+	return entry;
+}
 
-	do {
-		x += jump_speed;
-		y = -JUMP_DILATION * pow(x, 2);
 
-		colliding_obstacle(obstacles, renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, event, level_font, font_colour);
-		is_within_bounds(player_rect);
+/* Draws `text` a glyph at a time from cached single-character text with its top left corner at (`x`, `y`), or only measures it
+ * when `draw` is FALSE. Returns its width. Lower case is drawn upper case, like the baked glyphs. */
+int
+draw_glyphs(SDL_Renderer* renderer, Font* font, const char* text, SDL_Colour colour, int x, int y, int draw) {
+
+	int i, width = 0;
+	char str[2] = { 0, 0 };
+	TextTexture* glyph;
+	SDL_Rect rect;
+
+	for (i = 0; text[i] != '\0'; i++) {
+		str[0] = (char)toupper((unsigned char)text[i]);
+		glyph = get_text(renderer, font, str, colour);
+		if (draw) {
+			rect.x = x + width;
+			rect.y = y;
+			rect.w = glyph->width;
+			rect.h = glyph->height;
+			SDL_RenderCopy(renderer, glyph->texture, &glyph->source, &rect);
+		}
+		width += glyph->width;
+	}
+	return width;
+}
 
-		player_rect->x += jump_speed;
-		player_rect->y = player_start_y - y - (JUMP_DILATION * pow(HALF_JUMP_WIDTH, 2));
 
-		screen_scroll(player_rect, floor_rect, obstacles, TRUE, FALSE, renderer, player_colour);
+/* Returns the TTF font for live rendering in `font`, opening it on first use. The font file is read once, the first time any
+ * font is opened, and every size is opened from that copy in memory. */
+TTF_Font*
+font_ttf(Font* font) {
 
-		render_in_play(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, level_font, font_colour);
+	const double sizes[NUM_FONTS] = FONT_SIZES;
 
-		while (SDL_PollEvent(&event) != 0) {
-			if (event.type == SDL_KEYDOWN) {
-				if (event.key.keysym.sym == SDLK_SPACE) {
-					jump(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, event, window, level_font, font_colour);
-					return;
-				}
-				else if (event.key.keysym.sym == SDLK_ESCAPE) {
-					SDL_DestroyWindow(window);
-					exit(EXIT_SUCCESS);
-				}
-			}
+	if (font->ttf == NULL) {
+		if (font_data == NULL) {
+			assert((font_data = SDL_LoadFile(FONT, &font_data_size)) != NULL);
 		}
-
-		SDL_Delay(DELAY_FACTOR);
-	} while (is_alive && (x < 0));
-
-	if (is_alive) {
-		colliding_obstacle(obstacles, renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, event, level_font, font_colour);
-		fall_width_x = fall(renderer, bg_rect, player_rect, floor_rect, bg_colour, player_colour, floor_colour, obstacles, event, window, level_font, font_colour);
+		assert((font->ttf = TTF_OpenFontRW(SDL_RWFromConstMem(font_data, (int)font_data_size), 1, (int)sizes[font->id])) != NULL);
+		fonts_opened++;
 	}
+	return font->ttf;
 }
 
 
-/* Shifts all obstacles `n` pixels to the left. */
+/* Turns the baked atlas into one texture of text in `colour`. A build without a baked atlas leaves `atlas_texture` NULL, and all
+ * text is rendered live. */
 void
-shift_obstacles(SDL_Rect* player_rect, SDL_Rect** obstacles, int n) {
-	int i;
-	for (i = 0; i < NUM_OBSTACLES; i++) {
-		obstacles[i]->x -= n;
-	}
-}
-
+load_atlas(SDL_Renderer* renderer, SDL_Colour colour) {
 
-/* Returns an array of SDL_Rect* corresponding to holes or obstacles of arbitrary size and position. */
-SDL_Rect**
-get_obstacles(void) {
-	int i, rand_int, prev_obstacle_x = (W_WIDTH / 2) + OBSTACLE_SPACING, obstacle_x, obstacle_width, obstacle_height;
-	SDL_Rect** obstacles = (SDL_Rect**)malloc(NUM_OBSTACLES * sizeof(SDL_Rect*));
-	SDL_Rect* obstacle = NULL;
+	int x, y, stride = atlas_width / 8;
+	Uint32 ink, * pixels;
 
-	srand(time(NULL));
-
-	for (i = 0; i < NUM_OBSTACLES; i++) {
-		rand_int = (rand() % 3);
+	if (atlas_num_entries == 0) {
+		return;
+	}
 
-		if (rand_int == 0) {
-			obstacle_width = HOLE_WIDTH + (rand() % (int)XTEND_HOLE_WIDTH);
-			obstacle_x = prev_obstacle_x + (rand() % (int)XTEND_OBSTACLE_SPACING);
-			obstacle = get_rect(obstacle_x, HOLE_Y, obstacle_width, HOLE_HEIGHT);
-			prev_obstacle_x = obstacle_x + obstacle_width + OBSTACLE_SPACING;
-		}
-		else if (rand_int == 1) {
-			obstacle_width = OBSTACLE_WIDTH + (rand() % (int)XTEND_OBSTACLE_WIDTH);
-			obstacle_height = OBSTACLE_HEIGHT + (rand() % (int)XTEND_OBSTACLE_HEIGHT);
-			obstacle_x = prev_obstacle_x + (rand() % (int)XTEND_OBSTACLE_SPACING);
-			obstacle = get_rect(obstacle_x, FLOOR_Y - obstacle_height,
-				obstacle_width, obstacle_height);
-			prev_obstacle_x = obstacle_x + obstacle_width + OBSTACLE_SPACING;
+	// Pixels are expanded straight from the bits: no image decoder and no FreeType.
+	ink = ((Uint32)colour.r << 24) | ((Uint32)colour.g << 16) | ((Uint32)colour.b << 8) | SDL_ALPHA_OPAQUE;
+	pixels = (Uint32*)heap_alloc((size_t)atlas_width * atlas_height * sizeof(Uint32));
+	for (y = 0; y < atlas_height; y++) {
+		for (x = 0; x < atlas_width; x++) {
+			pixels[y * atlas_width + x] = (atlas_bits[y * stride + x / 8] & (0x80 >> (x % 8))) ? ink : 0;
 		}
-		else if (rand_int == 2) {
-			obstacle_width = OBSTACLE_WIDTH + (rand() % (int)XTEND_OBSTACLE_WIDTH);
-			obstacle_height = OBSTACLE_HEIGHT + (rand() % (int)XTEND_OBSTACLE_HEIGHT);
-			obstacle_height = (obstacle_height < (W_HEIGHT / 2)) ? (W_HEIGHT / 2) : obstacle_height;
-			obstacle_x = prev_obstacle_x + (rand() % (int)XTEND_OBSTACLE_SPACING);
-			obstacle = get_rect(obstacle_x, 0,
-				obstacle_width, obstacle_height);
-			prev_obstacle_x = obstacle_x + obstacle_width + OBSTACLE_SPACING;
-		}
-
-		obstacles[i] = obstacle;
 	}
 
-	return obstacles;
+	assert((atlas_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, atlas_width,
+		atlas_height)) != NULL);
+	assert(SDL_UpdateTexture(atlas_texture, NULL, pixels, atlas_width * sizeof(Uint32)) == 0);
+	assert(SDL_SetTextureBlendMode(atlas_texture, SDL_BLENDMODE_BLEND) == 0);
+	heap_free(pixels);
+	atlas_colour = colour;
 }
 
 
-/* Renders in-game play. */
+/* Destroys every cached text texture. Baked text shares the atlas texture, which is left to `quit`. */
 void
-render_in_play(SDL_Renderer* renderer, SDL_Rect* bg_rect, SDL_Rect* player_rect, SDL_Rect* floor_rect, SDL_Colour bg_colour, SDL_Colour player_colour,
-	SDL_Colour floor_colour, SDL_Rect** obstacles, TTF_Font* level_font, SDL_Colour font_colour) {
-
-	int i, is_hole, level_width, level_height, int_width, int_height;
-	char* int_level = (char*)malloc(LEVEL_DIGITS * sizeof(char));
-	SDL_Rect* obstacle;
-	SDL_Colour* colour;
-
-	int_level[0] = (char)level;
-	int_level[1] = '\0';
-
-	SDL_Surface* s_level = TTF_RenderText_Solid(level_font, LEVEL, font_colour);
-	SDL_Texture* t_level = SDL_CreateTextureFromSurface(renderer, s_level);
-	assert(TTF_SizeText(level_font, TITLE, &level_width, &level_height) == 0);
-	SDL_Rect* level_rect = get_rect(0, (W_HEIGHT - level_height), level_width, level_height);
-
-	SDL_Surface* s_level_int = TTF_RenderText_Solid(level_font, int_level, font_colour);
-	SDL_Texture* t_level_int = SDL_CreateTextureFromSurface(renderer, s_level_int);
-	assert(TTF_SizeText(level_font, int_level, &int_width, &int_height) == 0);
-	SDL_Rect* level_int_rect = get_rect(level_width + (2 * int_width), (W_HEIGHT - level_height), int_width, int_height);
-
-	SDL_SetRenderDrawColor(renderer, bg_colour.r, bg_colour.g, bg_colour.b, SDL_ALPHA_OPAQUE);
-	SDL_RenderFillRect(renderer, bg_rect);
-
-	SDL_SetRenderDrawColor(renderer, floor_colour.r, floor_colour.g, floor_colour.b, SDL_ALPHA_OPAQUE);
-	SDL_RenderFillRect(renderer, floor_rect);
-
-	for (i = 0; i < NUM_OBSTACLES; i++) {
-		obstacle = obstacles[i];
-		is_hole = (obstacles[i]->y == HOLE_Y) ? TRUE : FALSE;
-		colour = (is_hole) ? &bg_colour : &floor_colour;
-
-		SDL_SetRenderDrawColor(renderer, colour->r, colour->g, colour->b, SDL_ALPHA_OPAQUE);
-		SDL_RenderFillRect(renderer, obstacle);
+free_text_cache(void) {
+	int i;
+	for (i = 0; i < text_cache_count; i++) {
+		if (!text_cache[i].baked) {
+			SDL_DestroyTexture(text_cache[i].texture);
+		}
 	}
-
-	SDL_SetRenderDrawColor(renderer, player_colour.r, player_colour.g, player_colour.b, SDL_ALPHA_OPAQUE);
-	SDL_RenderFillRect(renderer, player_rect);
-
-	SDL_SetRenderDrawColor(renderer, font_colour.r, font_colour.g, font_colour.b, SDL_ALPHA_OPAQUE);
-	SDL_RenderCopy(renderer, t_level, NULL, level_rect);
-	SDL_RenderCopy(renderer, t_level_int, NULL, level_int_rect);
-
-	SDL_RenderPresent(renderer);
+	for (i = 0; i < NUM_OVERLAY_GLYPHS; i++) {
+		overlay_glyphs[i] = NULL;
+	}
+	text_cache_count = 0;
+	hud_label = NULL;
+	hud_level = NULL;
+	hud_cached_level = 0;
 }
 
 
-/* Renders pre-game screen. */
+/* Rasterizes the HUD label and the level letters A-Z up front so that no text is rendered during play. */
 void
-render_pre_play(SDL_Renderer* renderer, SDL_Rect* bg_rect, TTF_Font* title_font, TTF_Font* message_font, SDL_Colour font_colour,
-	SDL_Colour bg_colour) {
-
-	int title_width, title_height, message_width, message_height;
-
-	SDL_Surface* s_title = TTF_RenderText_Solid(title_font, TITLE, font_colour);
-	SDL_Texture* t_title = SDL_CreateTextureFromSurface(renderer, s_title);
-	assert(TTF_SizeText(title_font, TITLE, &title_width, &title_height) == 0);
-	SDL_Rect* title_rect = get_rect((W_WIDTH - title_width) / 2, (W_HEIGHT - title_height) / 2, title_width, title_height);
-
-	SDL_Surface* s_instruction_1 = TTF_RenderText_Solid(message_font, STR_INSTRUCTION_1, font_colour);
-	SDL_Texture* t_instruction_1 = SDL_CreateTextureFromSurface(renderer, s_instruction_1);
-	assert(TTF_SizeText(message_font, STR_INSTRUCTION_1, &message_width, &message_height) == 0);
-	SDL_Rect* instruction_1_rect = get_rect((W_WIDTH - message_width) / 2, (W_HEIGHT - title_height) / 2 + title_height,
-		message_width, message_height);
+prepare_hud(SDL_Renderer* renderer, Font* level_font, SDL_Colour font_colour) {
 
-	SDL_Surface* s_instruction_2 = TTF_RenderText_Solid(message_font, STR_INSTRUCTION_2, font_colour);
-	SDL_Texture* t_instruction_2 = SDL_CreateTextureFromSurface(renderer, s_instruction_2);
-	assert(TTF_SizeText(message_font, STR_INSTRUCTION_2, &message_width, &message_height) == 0);
-	SDL_Rect* instruction_2_rect = get_rect((W_WIDTH - message_width) / 2, instruction_1_rect->y + message_height,
-		message_width, message_height);
-
-	SDL_SetRenderDrawColor(renderer, bg_colour.r, bg_colour.g, bg_colour.b, SDL_ALPHA_OPAQUE);
-	SDL_RenderFillRect(renderer, bg_rect);
+	int i;
+	char int_level[LEVEL_DIGITS];
+	TextTexture* t_title = get_text(renderer, level_font, TITLE, font_colour);
 
-	SDL_SetRenderDrawColor(renderer, font_colour.r, font_colour.g, font_colour.b, SDL_ALPHA_OPAQUE);
-	SDL_RenderCopy(renderer, t_title, NULL, title_rect);
-	SDL_RenderCopy(renderer, t_instruction_1, NULL, instruction_1_rect);
-	SDL_RenderCopy(renderer, t_instruction_2, NULL, instruction_2_rect);
+	hud_label = get_text(renderer, level_font, LEVEL, font_colour);
+	hud_label_text.texture = hud_label->texture;
+	hud_label_text.source = hud_label->source;
+	hud_label_text.rect.x = 0;
+	hud_label_text.rect.y = W_HEIGHT - t_title->height;
+	hud_label_text.rect.w = t_title->width;
+	hud_label_text.rect.h = t_title->height;
 
-	SDL_RenderPresent(renderer);
+	int_level[1] = '\0';
+	for (i = 0; i < NUM_LEVEL_GLYPHS; i++) {
+		int_level[0] = (char)(ASCII_A + i);
+		hud_level_glyphs[i] = get_text(renderer, level_font, int_level, font_colour);
+	}
+	hud_cached_level = 0;
 }
-
-
-/* Returns a SDL_Rect* with: top left vertex (start_coordinate_x, start_coordinate_y) and size `width` X `height`. */
-SDL_Rect*
-get_rect(int start_coordinate_x, int start_coordinate_y, int width, int height) {
-	SDL_Rect* rectangle = (SDL_Rect*)malloc(sizeof(SDL_Rect));
-	assert(rectangle != NULL);
-	rectangle->x = start_coordinate_x;
-	rectangle->y = start_coordinate_y;
-	rectangle->w = width;
-	rectangle->h = height;
-	return rectangle;
-}
\ No newline at end of file
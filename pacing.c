@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <assert.h>
+#include "game.h"
+#include "pacing.h"
+#include "profile.h"
+
+
+int vsync_requested = FALSE;
+int vsync_enabled = FALSE;
+int refresh_rate = DEFAULT_REFRESH_RATE;
+int target_fps = DEFAULT_REFRESH_RATE;
+int vsync_drops = 0;
+
+int vsync_supported = FALSE;
+int missed_frames = 0;
+int fast_frames = 0;
+Uint64 next_deadline = 0;
+Uint64 last_pace_end = 0;
+char mode_text[PACING_MODE_LENGTH];
+
+
+static void set_vsync(SDL_Renderer* renderer, int vsync);
+
+
+/* Creates the window's renderer, asking for vsync if `vsync` is set, and caps frames at `fps` (0 for no cap, negative for the
+ * display's refresh rate). Falls back to any renderer the driver has if there is no accelerated one. */
+SDL_Renderer*
+create_renderer(SDL_Window* window, int vsync, int fps) {
+
+	int display;
+	Uint32 vsync_flag = vsync ? SDL_RENDERER_PRESENTVSYNC : 0;
+	SDL_Renderer* renderer;
+	SDL_RendererInfo info;
+	SDL_DisplayMode display_mode;
+
+	if ((renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | vsync_flag)) == NULL) {
+		assert((renderer = SDL_CreateRenderer(window, -1, vsync_flag)) != NULL);
+	}
+
+	// Drivers may quietly ignore the vsync flag; the renderer's info says whether it was honoured.
+	assert(SDL_GetRendererInfo(renderer, &info) == 0);
+	vsync_requested = vsync;
+	vsync_enabled = (info.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+	vsync_supported = vsync_enabled;
+
+	refresh_rate = DEFAULT_REFRESH_RATE;
+	if ((display = SDL_GetWindowDisplayIndex(window)) >= 0 && SDL_GetCurrentDisplayMode(display, &display_mode) == 0 &&
+		display_mode.refresh_rate > 0) {
+		refresh_rate = display_mode.refresh_rate;
+	}
+	target_fps = (fps < 0) ? refresh_rate : fps;
+
+	missed_frames = 0;
+	fast_frames = 0;
+	vsync_drops = 0;
+	next_deadline = 0;
+	last_pace_end = 0;
+	return renderer;
+}
+
+
+/* Ends a frame after it has been presented: adapts vsync to how long frames are taking and sleeps until the next frame is due
+ * under the FPS cap. Never busy-waits. */
+void
+pace_frame(SDL_Renderer* renderer) {
+
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 refresh_interval = frequency / refresh_rate;
+	Uint64 target_interval, remaining_us;
+	Uint64 phase_start = phase_begin();
+
+	// Frame time here excludes the software cap's own sleep but includes waiting for vsync in present.
+	if (last_pace_end != 0 && vsync_supported) {
+		if (vsync_enabled) {
+			missed_frames = (now - last_pace_end > VSYNC_MISS_FACTOR * refresh_interval) ? missed_frames + 1 : 0;
+			if (missed_frames >= VSYNC_MISSES) {
+				set_vsync(renderer, FALSE);
+				vsync_drops += !vsync_enabled;
+			}
+		}
+		else {
+			fast_frames = (now - last_pace_end < VSYNC_HIT_FACTOR * refresh_interval) ? fast_frames + 1 : 0;
+			if (fast_frames >= VSYNC_HITS) {
+				set_vsync(renderer, TRUE);
+			}
+		}
+	}
+
+	// With vsync on, present already waits for the display, so the software cap only holds frames back when vsync is off or the
+	// target is below the refresh rate. Frames are released on a fixed grid of deadlines so that oversleeping in one frame is made
+	// up in the next instead of adding up; a frame more than an interval late restarts the grid rather than rushing to catch up.
+	if (target_fps > 0 && (!vsync_enabled || target_fps < refresh_rate)) {
+		target_interval = frequency / target_fps;
+		next_deadline += target_interval;
+		if (now > next_deadline + target_interval) {
+			next_deadline = now;
+		}
+		if (next_deadline > now) {
+			remaining_us = (next_deadline - now) * 1000000 / frequency;
+			if (remaining_us > PACE_WAKE_US) {
+				SDL_Delay((Uint32)((remaining_us - PACE_WAKE_US) / 1000));
+			}
+		}
+	}
+	else {
+		next_deadline = now;
+	}
+
+	phase_end(PHASE_SLEEP, phase_start);
+	last_pace_end = SDL_GetPerformanceCounter();
+}
+
+
+/* Returns a description of how frames are currently paced, e.g. "vsync 60 hz" or "cap 144 fps (vsync dropped 2 times)". */
+const char*
+pacing_mode(void) {
+
+	int length;
+
+	if (vsync_enabled) {
+		length = snprintf(mode_text, sizeof(mode_text), "vsync %d hz", refresh_rate);
+		if (target_fps > 0 && target_fps < refresh_rate) {
+			length += snprintf(mode_text + length, sizeof(mode_text) - length, ", cap %d fps", target_fps);
+		}
+	}
+	else if (target_fps > 0) {
+		length = snprintf(mode_text, sizeof(mode_text), "cap %d fps", target_fps);
+	}
+	else {
+		length = snprintf(mode_text, sizeof(mode_text), "uncapped");
+	}
+
+	if (vsync_requested && !vsync_supported) {
+		snprintf(mode_text + length, sizeof(mode_text) - length, " (no vsync)");
+	}
+	else if (vsync_drops > 0) {
+		snprintf(mode_text + length, sizeof(mode_text) - length, " (vsync dropped %d times)", vsync_drops);
+	}
+	return mode_text;
+}
+
+
+/* Turns vsync on or off on an existing renderer. SDL before 2.0.18 can only set vsync when the renderer is created, so there
+ * vsync stays as it is. */
+static void
+set_vsync(SDL_Renderer* renderer, int vsync) {
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	if (SDL_RenderSetVSync(renderer, vsync) == 0) {
+		vsync_enabled = vsync;
+	}
+#else
+	(void)renderer;
+#endif
+	missed_frames = 0;
+	fast_frames = 0;
+}
@@ -0,0 +1,34 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include "SDL.h"
+
+// Used when the display does not report its refresh rate.
+#define DEFAULT_REFRESH_RATE 60
+
+// Adaptive vsync: after `VSYNC_MISSES` frames in a row take longer than `VSYNC_MISS_FACTOR` refresh intervals, vsync is turned off
+// so a slow frame tears instead of waiting a whole extra interval. It comes back on after `VSYNC_HITS` frames in a row fit in
+// `VSYNC_HIT_FACTOR` of an interval.
+#define VSYNC_MISS_FACTOR 1.5
+#define VSYNC_MISSES 8
+#define VSYNC_HIT_FACTOR 0.75
+#define VSYNC_HITS 120
+
+// The software cap sleeps with `SDL_Delay`, which can oversleep by about a millisecond, so it wakes up a little early.
+#define PACE_WAKE_US 1000
+
+#define PACING_MODE_LENGTH 48
+
+
+extern int vsync_requested;
+extern int vsync_enabled;
+extern int refresh_rate;
+extern int target_fps;
+extern int vsync_drops;
+
+
+SDL_Renderer* create_renderer(SDL_Window* window, int vsync, int fps);
+void pace_frame(SDL_Renderer* renderer);
+const char* pacing_mode(void);
+
+#endif
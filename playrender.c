@@ -0,0 +1,180 @@
+#include "game.h"
+#include "playrender.h"
+
+
+int draw_calls = 0;
+int max_draw_calls = 0;
+
+// The background, floor and HUD only change when the level does, so they are kept in render target textures and redrawn only
+// when they change or the renderer loses its targets. Without render target support they are drawn directly every frame.
+SDL_Texture* world_layer = NULL;
+SDL_Texture* hud_layer = NULL;
+SDL_Rect hud_layer_rect;
+int world_layer_dirty = TRUE;
+int hud_layer_dirty = TRUE;
+
+// Set by whoever owns the text: the level label, and the letter of the current level. The HUD layer must be marked dirty when
+// either changes.
+HudText hud_label_text;
+HudText hud_level_text;
+
+
+static void draw_world_layer(SDL_Renderer* renderer, const SDL_Rect* bg_rect, const SDL_Rect* floor_rect, SDL_Colour bg_colour,
+	SDL_Colour floor_colour);
+static void draw_hud_layer(SDL_Renderer* renderer);
+static void copy_hud_text(SDL_Renderer* renderer, const HudText* text, const SDL_Rect* rect);
+
+
+/* Creates the render target textures for the world and HUD layers, if the renderer supports render targets; if it doesn't, or
+ * either can't be created, the layers are drawn directly. The HUD layer is a transparent strip along the bottom of the screen,
+ * as tall as the level label, which must already be placed. */
+void
+prepare_layers(SDL_Renderer* renderer) {
+
+	if (!SDL_RenderTargetSupported(renderer)) {
+		return;
+	}
+
+	hud_layer_rect.x = 0;
+	hud_layer_rect.y = hud_label_text.rect.y;
+	hud_layer_rect.w = W_WIDTH;
+	hud_layer_rect.h = hud_label_text.rect.h;
+	world_layer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, W_WIDTH, W_HEIGHT);
+	hud_layer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, hud_layer_rect.w, hud_layer_rect.h);
+	if (world_layer == NULL || hud_layer == NULL) {
+		free_layers();
+		return;
+	}
+	SDL_SetTextureBlendMode(hud_layer, SDL_BLENDMODE_BLEND);
+
+	world_layer_dirty = TRUE;
+	hud_layer_dirty = TRUE;
+}
+
+
+/* Destroys the layer textures. */
+void
+free_layers(void) {
+	if (world_layer != NULL) {
+		SDL_DestroyTexture(world_layer);
+		world_layer = NULL;
+	}
+	if (hud_layer != NULL) {
+		SDL_DestroyTexture(hud_layer);
+		hud_layer = NULL;
+	}
+}
+
+
+/* Draws in-game play, without presenting it, with the camera at world x `camera` and the player and the first `num_ghosts` ghost
+ * rects already in screen coordinates. Obstacles off the screen are culled and the rest are drawn in one batch per colour, so a
+ * frame takes the same few draw calls however long the course is and however many ghosts there are. The background, floor and
+ * HUD come from their cached layers. The game and the benchmark both draw through here, so the benchmark times what the game
+ * submits. */
+void
+render_play(SDL_Renderer* renderer, Game* game, Course* course, int camera, const SDL_Rect* bg_rect, const SDL_Rect* floor_rect,
+	const SDL_Rect* player_rect, const SDL_Rect* ghost_rects, int num_ghosts, SDL_Colour bg_colour, SDL_Colour floor_colour,
+	SDL_Colour player_colour, SDL_Colour ghost_colour) {
+
+	int num_blocks, num_holes;
+	SDL_Rect blocks[MAX_VISIBLE_OBSTACLES], holes[MAX_VISIBLE_OBSTACLES];
+
+	// Holes are cut out of the floor in the background colour, so they go after it.
+	num_blocks = visible_obstacles(game, course, camera, blocks, holes, &num_holes);
+
+	draw_calls = 0;
+	if (world_layer != NULL) {
+		if (world_layer_dirty) {
+			draw_world_layer(renderer, bg_rect, floor_rect, bg_colour, floor_colour);
+		}
+		copy_texture(renderer, world_layer, bg_rect);
+	}
+	else {
+		fill_rects(renderer, bg_colour, bg_rect, 1);
+		fill_rects(renderer, floor_colour, floor_rect, 1);
+	}
+	fill_rects(renderer, floor_colour, blocks, num_blocks);
+	fill_rects(renderer, bg_colour, holes, num_holes);
+	fill_rects(renderer, ghost_colour, ghost_rects, num_ghosts);
+	fill_rects(renderer, player_colour, player_rect, 1);
+
+	if (hud_layer != NULL) {
+		if (hud_layer_dirty) {
+			draw_hud_layer(renderer);
+		}
+		copy_texture(renderer, hud_layer, &hud_layer_rect);
+	}
+	else {
+		copy_hud_text(renderer, &hud_label_text, &hud_label_text.rect);
+		copy_hud_text(renderer, &hud_level_text, &hud_level_text.rect);
+	}
+
+	if (draw_calls > max_draw_calls) {
+		max_draw_calls = draw_calls;
+	}
+}
+
+
+/* Fills `count` rects in one draw call. Empty batches are skipped. */
+void
+fill_rects(SDL_Renderer* renderer, SDL_Colour colour, const SDL_Rect* rects, int count) {
+	if (count > 0) {
+		SDL_SetRenderDrawColor(renderer, colour.r, colour.g, colour.b, SDL_ALPHA_OPAQUE);
+		SDL_RenderFillRects(renderer, rects, count);
+		draw_calls++;
+	}
+}
+
+
+/* Copies a whole texture to `rect` and counts the draw call. */
+void
+copy_texture(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* rect) {
+	SDL_RenderCopy(renderer, texture, NULL, rect);
+	draw_calls++;
+}
+
+
+/* Redraws the background and floor into the world layer. It stays dirty, to be tried again next frame, if it can't be drawn to. */
+static void
+draw_world_layer(SDL_Renderer* renderer, const SDL_Rect* bg_rect, const SDL_Rect* floor_rect, SDL_Colour bg_colour,
+	SDL_Colour floor_colour) {
+
+	if (SDL_SetRenderTarget(renderer, world_layer) != 0) {
+		return;
+	}
+	fill_rects(renderer, bg_colour, bg_rect, 1);
+	fill_rects(renderer, floor_colour, floor_rect, 1);
+	SDL_SetRenderTarget(renderer, NULL);
+	world_layer_dirty = FALSE;
+}
+
+
+/* Redraws the level label and the current level letter into the HUD layer, over a transparent background. Like the world
+ * layer, it stays dirty if it can't be drawn to. */
+static void
+draw_hud_layer(SDL_Renderer* renderer) {
+
+	SDL_Rect label_rect = hud_label_text.rect, level_rect = hud_level_text.rect;
+
+	label_rect.y -= hud_layer_rect.y;
+	level_rect.y -= hud_layer_rect.y;
+
+	if (SDL_SetRenderTarget(renderer, hud_layer) != 0) {
+		return;
+	}
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_TRANSPARENT);
+	SDL_RenderClear(renderer);
+	copy_hud_text(renderer, &hud_label_text, &label_rect);
+	copy_hud_text(renderer, &hud_level_text, &level_rect);
+	SDL_SetRenderTarget(renderer, NULL);
+	hud_layer_dirty = FALSE;
+}
+
+
+/* Copies HUD text to `rect` and counts the draw call. */
+static void
+copy_hud_text(SDL_Renderer* renderer, const HudText* text, const SDL_Rect* rect) {
+	SDL_RenderCopy(renderer, text->texture, &text->source, rect);
+	draw_calls++;
+}
@@ -0,0 +1,31 @@
+#ifndef PLAYRENDER_H
+#define PLAYRENDER_H
+
+#include "SDL.h"
+#include "game.h"
+
+
+/* A piece of HUD text as it is drawn: the `source` rect of `texture` it is in, and the `rect` it fills on screen. */
+typedef struct {
+	SDL_Texture* texture;
+	SDL_Rect source;
+	SDL_Rect rect;
+} HudText;
+
+
+extern int draw_calls;
+extern int max_draw_calls;
+extern int world_layer_dirty;
+extern int hud_layer_dirty;
+extern HudText hud_label_text;
+extern HudText hud_level_text;
+
+void prepare_layers(SDL_Renderer* renderer);
+void free_layers(void);
+void render_play(SDL_Renderer* renderer, Game* game, Course* course, int camera, const SDL_Rect* bg_rect, const SDL_Rect* floor_rect,
+	const SDL_Rect* player_rect, const SDL_Rect* ghost_rects, int num_ghosts, SDL_Colour bg_colour, SDL_Colour floor_colour,
+	SDL_Colour player_colour, SDL_Colour ghost_colour);
+void fill_rects(SDL_Renderer* renderer, SDL_Colour colour, const SDL_Rect* rects, int count);
+void copy_texture(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* rect);
+
+#endif
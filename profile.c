@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "game.h"
+#include "profile.h"
+
+
+/* Per-phase frame times of one frame, in microseconds, queued for the trace writer. */
+typedef struct {
+	Uint32 frame;
+	float us[NUM_PHASES];
+} TraceSample;
+
+
+int profile_enabled = FALSE;
+Uint64 phase_ticks[NUM_PHASES];
+const char* phase_names[NUM_PHASES] = { "input", "update", "collision", "scroll", "render", "text", "present", "sleep", "frame" };
+
+Uint32 phase_histogram[NUM_PHASES][PROFILE_BUCKETS];
+double phase_max[NUM_PHASES];
+long frames_profiled = 0;
+Uint64 last_frame_counter = 0;
+
+// The trace queue is filled by the game loop and drained by the writer thread; frames are dropped rather than stall the game.
+TraceSample trace_queue[TRACE_QUEUE_SIZE];
+int trace_head = 0;
+int trace_count = 0;
+int trace_running = FALSE;
+long trace_dropped = 0;
+FILE* trace_file = NULL;
+SDL_Thread* trace_thread = NULL;
+SDL_mutex* trace_lock = NULL;
+SDL_cond* trace_ready = NULL;
+
+
+static int trace_writer(void* data);
+
+
+/* Clears all frame statistics and starts timing the first frame. */
+void
+profile_reset(void) {
+
+	int i, j;
+
+	for (i = 0; i < NUM_PHASES; i++) {
+		phase_ticks[i] = 0;
+		phase_max[i] = 0;
+		for (j = 0; j < PROFILE_BUCKETS; j++) {
+			phase_histogram[i][j] = 0;
+		}
+	}
+	frames_profiled = 0;
+	last_frame_counter = SDL_GetPerformanceCounter();
+}
+
+
+/* Closes the current frame: adds its phase times to the statistics and the trace, then starts the next frame. */
+void
+profile_frame_end(void) {
+
+	int i, bucket;
+	double us;
+	Uint64 counter = SDL_GetPerformanceCounter();
+	TraceSample* sample = NULL;
+
+	if (!profile_enabled) {
+		return;
+	}
+	phase_ticks[PHASE_FRAME] = counter - last_frame_counter;
+	last_frame_counter = counter;
+
+	if (trace_running) {
+		SDL_LockMutex(trace_lock);
+		if (trace_count < TRACE_QUEUE_SIZE) {
+			sample = &trace_queue[(trace_head + trace_count) % TRACE_QUEUE_SIZE];
+			sample->frame = (Uint32)frames_profiled;
+		}
+		else {
+			trace_dropped++;
+		}
+	}
+
+	for (i = 0; i < NUM_PHASES; i++) {
+		us = (double)phase_ticks[i] * 1000000.0 / SDL_GetPerformanceFrequency();
+		bucket = (int)(us / PROFILE_BUCKET_US);
+		phase_histogram[i][(bucket < PROFILE_BUCKETS) ? bucket : (PROFILE_BUCKETS - 1)]++;
+		if (us > phase_max[i]) {
+			phase_max[i] = us;
+		}
+		if (sample != NULL) {
+			sample->us[i] = (float)us;
+		}
+		phase_ticks[i] = 0;
+	}
+	frames_profiled++;
+
+	if (trace_running) {
+		if (sample != NULL) {
+			trace_count++;
+			SDL_CondSignal(trace_ready);
+		}
+		SDL_UnlockMutex(trace_lock);
+	}
+}
+
+
+/* Returns the time in milliseconds that `fraction` (0 to 1) of the profiled frames spent in `phase` at most, to the histogram's
+ * resolution. */
+double
+profile_percentile(int phase, double fraction) {
+
+	int i;
+	long seen = 0, target = (long)(fraction * frames_profiled);
+
+	if (frames_profiled == 0) {
+		return 0;
+	}
+	for (i = 0; i < PROFILE_BUCKETS - 1; i++) {
+		seen += phase_histogram[phase][i];
+		if (seen > target) {
+			break;
+		}
+	}
+	// A bucket's upper edge, but never more than the slowest frame actually seen.
+	return ((i + 1) * PROFILE_BUCKET_US < phase_max[phase]) ? ((i + 1) * PROFILE_BUCKET_US / 1000.0) : profile_max(phase);
+}
+
+
+/* Returns the longest time in milliseconds a frame spent in `phase`. */
+double
+profile_max(int phase) {
+	return phase_max[phase] / 1000.0;
+}
+
+
+/* Returns the number of frames profiled since the last reset. */
+long
+profile_frames(void) {
+	return frames_profiled;
+}
+
+
+/* Prints p50, p99 and max of every phase. */
+void
+print_profile(FILE* out) {
+
+	int i;
+
+	fprintf(out, "%-10s %8s %8s %8s  (ms over %ld frames)\n", "phase", "p50", "p99", "max", frames_profiled);
+	for (i = 0; i < NUM_PHASES; i++) {
+		fprintf(out, "%-10s %8.2f %8.2f %8.2f\n", phase_names[i], profile_percentile(i, 0.5), profile_percentile(i, 0.99),
+			profile_max(i));
+	}
+}
+
+
+/* Starts streaming per-frame phase times as CSV to `path` from a background thread. Returns FALSE if the file can't be opened or
+ * the thread can't be started. */
+int
+start_trace(const char* path) {
+
+	int i;
+
+	assert(!trace_running);
+	if ((trace_file = fopen(path, "w")) == NULL) {
+		return FALSE;
+	}
+	fprintf(trace_file, "frame");
+	for (i = 0; i < NUM_PHASES; i++) {
+		fprintf(trace_file, ",%s_us", phase_names[i]);
+	}
+	fprintf(trace_file, "\n");
+
+	trace_head = 0;
+	trace_count = 0;
+	trace_dropped = 0;
+	trace_lock = SDL_CreateMutex();
+	trace_ready = SDL_CreateCond();
+	trace_running = TRUE;
+	trace_thread = (trace_lock != NULL && trace_ready != NULL) ? SDL_CreateThread(trace_writer, "trace writer", NULL) : NULL;
+	if (trace_thread == NULL) {
+		fprintf(stderr, "could not start the trace writer: %s\n", SDL_GetError());
+		trace_running = FALSE;
+		SDL_DestroyCond(trace_ready);
+		SDL_DestroyMutex(trace_lock);
+		fclose(trace_file);
+		trace_file = NULL;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+/* Writes out the queued frames, stops the writer thread and closes the trace. */
+void
+stop_trace(void) {
+
+	if (!trace_running) {
+		return;
+	}
+	SDL_LockMutex(trace_lock);
+	trace_running = FALSE;
+	SDL_CondSignal(trace_ready);
+	SDL_UnlockMutex(trace_lock);
+	SDL_WaitThread(trace_thread, NULL);
+
+	if (trace_dropped > 0) {
+		fprintf(stderr, "trace: dropped %ld frames\n", trace_dropped);
+	}
+	fclose(trace_file);
+	SDL_DestroyCond(trace_ready);
+	SDL_DestroyMutex(trace_lock);
+	trace_file = NULL;
+	trace_thread = NULL;
+}
+
+
+/* Writer thread: takes queued frames in batches and formats them outside the lock until the trace is stopped and drained. */
+static int
+trace_writer(void* data) {
+
+	int i, j, n;
+	TraceSample batch[TRACE_QUEUE_SIZE];
+
+	(void)data;
+	for (;;) {
+		SDL_LockMutex(trace_lock);
+		while (trace_count == 0 && trace_running) {
+			SDL_CondWait(trace_ready, trace_lock);
+		}
+		if (trace_count == 0) {
+			SDL_UnlockMutex(trace_lock);
+			return 0;
+		}
+		for (n = 0; n < trace_count; n++) {
+			batch[n] = trace_queue[(trace_head + n) % TRACE_QUEUE_SIZE];
+		}
+		trace_head = (trace_head + n) % TRACE_QUEUE_SIZE;
+		trace_count = 0;
+		SDL_UnlockMutex(trace_lock);
+
+		for (i = 0; i < n; i++) {
+			fprintf(trace_file, "%u", batch[i].frame);
+			for (j = 0; j < NUM_PHASES; j++) {
+				fprintf(trace_file, ",%.1f", batch[i].us[j]);
+			}
+			fprintf(trace_file, "\n");
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+#include "SDL.h"
+
+// Phases of a frame. Update includes the collision and scroll time spent inside it; frame is the whole frame, wall clock.
+#define PHASE_INPUT 0
+#define PHASE_UPDATE 1
+#define PHASE_COLLISION 2
+#define PHASE_SCROLL 3
+#define PHASE_RENDER 4
+#define PHASE_TEXT 5
+#define PHASE_PRESENT 6
+#define PHASE_SLEEP 7
+#define PHASE_FRAME 8
+#define NUM_PHASES 9
+
+// Frame time histograms have `PROFILE_BUCKET_US` resolution up to `PROFILE_BUCKETS` buckets; longer frames land in the last one.
+#define PROFILE_BUCKET_US 10
+#define PROFILE_BUCKETS 5000
+#define TRACE_QUEUE_SIZE 1024
+
+
+extern int profile_enabled;
+extern Uint64 phase_ticks[NUM_PHASES];
+extern const char* phase_names[NUM_PHASES];
+
+
+void profile_reset(void);
+void profile_frame_end(void);
+double profile_percentile(int phase, double fraction);
+double profile_max(int phase);
+long profile_frames(void);
+void print_profile(FILE* out);
+int start_trace(const char* path);
+void stop_trace(void);
+
+
+/* Starts timing a phase. Free when profiling is off. */
+static inline Uint64
+phase_begin(void) {
+	return profile_enabled ? SDL_GetPerformanceCounter() : 0;
+}
+
+
+/* Adds the time since `start` to `phase` for the current frame. */
+static inline void
+phase_end(int phase, Uint64 start) {
+	if (profile_enabled) {
+		phase_ticks[phase] += SDL_GetPerformanceCounter() - start;
+	}
+}
+
+#endif
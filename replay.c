@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "game.h"
+#include "replay.h"
+
+#define REPLAY_INITIAL_CAPACITY 4096
+#define REPLAY_HEADER_SIZE 29
+
+
+static void put_u32(Uint8* out, Uint32 value);
+static Uint32 get_u32(const Uint8* in);
+
+
+/* Starts an empty recording of a game on the course of `seed`. */
+void
+new_replay(Replay* replay, Uint64 seed, int course_length) {
+	replay->seed = seed;
+	replay->course_length = course_length;
+	replay->final_tick = 0;
+	replay->checksum = 0;
+	replay->num_events = 0;
+	replay->capacity = REPLAY_INITIAL_CAPACITY;
+	replay->cursor = 0;
+	replay->events = (ReplayEvent*)heap_alloc(replay->capacity * sizeof(ReplayEvent));
+}
+
+
+/* Frees the events of a replay. */
+void
+free_replay(Replay* replay) {
+	heap_free(replay->events);
+	replay->events = NULL;
+	replay->num_events = 0;
+	replay->capacity = 0;
+}
+
+
+/* Appends an input to the recording. Inputs must be recorded in tick order. */
+void
+replay_record(Replay* replay, Uint32 tick, int type) {
+
+	assert(replay->num_events == 0 || replay->events[replay->num_events - 1].tick <= tick);
+	if (replay->num_events == replay->capacity) {
+		replay->capacity *= 2;
+		replay->events = (ReplayEvent*)heap_realloc(replay->events, replay->capacity * sizeof(ReplayEvent));
+	}
+	replay->events[replay->num_events].tick = tick;
+	replay->events[replay->num_events].type = (Uint8)type;
+	replay->num_events++;
+}
+
+
+/* Stamps the recording with the tick the game ended on and the state checksum at that tick. */
+void
+replay_finish(Replay* replay, Uint32 final_tick, Uint32 checksum) {
+	replay->final_tick = final_tick;
+	replay->checksum = checksum;
+}
+
+
+/* Feeds `game` every recorded input due at its current tick. Call before each update. */
+void
+replay_apply(Replay* replay, Game* game) {
+	while (replay->cursor < replay->num_events && replay->events[replay->cursor].tick <= game->tick) {
+		game_command(game, replay->events[replay->cursor].type);
+		replay->cursor++;
+	}
+}
+
+
+/* Moves playback to `tick`, so the next `replay_apply` feeds the inputs from that tick on. Used after a game is rewound. */
+void
+replay_seek(Replay* replay, Uint32 tick) {
+
+	int low = 0, high = replay->num_events, middle;
+
+	while (low < high) {
+		middle = low + (high - low) / 2;
+		if (replay->events[middle].tick < tick) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	replay->cursor = low;
+}
+
+
+/* Writes a replay to `path`. Returns FALSE if the file could not be written. */
+int
+save_replay(const Replay* replay, const char* path) {
+
+	int i, ok;
+	Uint8 header[REPLAY_HEADER_SIZE], event[6];
+	Uint32 delta, previous_tick = 0;
+	size_t length;
+	FILE* file = fopen(path, "wb");
+
+	if (file == NULL) {
+		return FALSE;
+	}
+
+	memcpy(header, REPLAY_MAGIC, 4);
+	header[4] = REPLAY_VERSION;
+	put_u32(header + 5, (Uint32)replay->seed);
+	put_u32(header + 9, (Uint32)(replay->seed >> 32));
+	put_u32(header + 13, (Uint32)replay->course_length);
+	put_u32(header + 17, replay->final_tick);
+	put_u32(header + 21, replay->checksum);
+	put_u32(header + 25, (Uint32)replay->num_events);
+	ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+
+	for (i = 0; i < replay->num_events && ok; i++) {
+		delta = replay->events[i].tick - previous_tick;
+		previous_tick = replay->events[i].tick;
+		length = 0;
+		do {
+			event[length++] = (Uint8)((delta & 0x7F) | ((delta > 0x7F) ? 0x80 : 0));
+			delta >>= 7;
+		} while (delta != 0);
+		event[length++] = replay->events[i].type;
+		ok = fwrite(event, 1, length, file) == length;
+	}
+
+	return (fclose(file) == 0) && ok;
+}
+
+
+/* Reads a replay written by `save_replay` from `path` into `replay`, which must be freed with `free_replay`. Returns FALSE if the
+ * file is missing, truncated, not a replay, of a course longer than `MAX_COURSE_LENGTH`, or holds an event count, tick or input
+ * no recording could; `replay` is then left empty. */
+int
+load_replay(Replay* replay, const char* path) {
+
+	int i, shift, byte = 0, num_events, course_length, ok = TRUE;
+	Uint8 header[REPLAY_HEADER_SIZE];
+	Uint32 delta, tick = 0;
+	FILE* file = fopen(path, "rb");
+
+	if (file == NULL) {
+		return FALSE;
+	}
+	if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, REPLAY_MAGIC, 4) != 0 ||
+		header[4] != REPLAY_VERSION) {
+		fclose(file);
+		return FALSE;
+	}
+
+	// A course no game could have been played on, or a negative number of inputs, is as good as a corrupt file.
+	course_length = (int)get_u32(header + 13);
+	num_events = (int)get_u32(header + 25);
+	if (course_length < 0 || course_length > MAX_COURSE_LENGTH || num_events < 0) {
+		fclose(file);
+		return FALSE;
+	}
+
+	new_replay(replay, get_u32(header + 5) | ((Uint64)get_u32(header + 9) << 32), course_length);
+	replay->final_tick = get_u32(header + 17);
+	replay->checksum = get_u32(header + 21);
+
+	// Each event must be read whole, keep the ticks in order without wrapping around, and be an input the game records.
+	for (i = 0; i < num_events && ok; i++) {
+		delta = 0;
+		shift = 0;
+		do {
+			byte = fgetc(file);
+			delta |= (Uint32)(byte & 0x7F) << shift;
+			shift += 7;
+		} while (byte != EOF && (byte & 0x80) && shift < 32);
+		ok = (byte != EOF) && (tick + delta >= tick);
+		tick += delta;
+		if (ok) {
+			byte = fgetc(file);
+			ok = (byte == REPLAY_JUMP);
+		}
+		if (ok) {
+			replay_record(replay, tick, byte);
+		}
+	}
+	fclose(file);
+
+	if (!ok) {
+		free_replay(replay);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+/* Writes `value` as four little-endian bytes. */
+static void
+put_u32(Uint8* out, Uint32 value) {
+	out[0] = (Uint8)value;
+	out[1] = (Uint8)(value >> 8);
+	out[2] = (Uint8)(value >> 16);
+	out[3] = (Uint8)(value >> 24);
+}
+
+
+/* Reads four little-endian bytes. */
+static Uint32
+get_u32(const Uint8* in) {
+	return (Uint32)in[0] | ((Uint32)in[1] << 8) | ((Uint32)in[2] << 16) | ((Uint32)in[3] << 24);
+}
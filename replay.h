@@ -0,0 +1,45 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "SDL.h"
+#include "game.h"
+
+#define REPLAY_MAGIC "SQJR"
+#define REPLAY_VERSION 2
+
+#define REPLAY_JUMP COMMAND_JUMP
+
+
+/* One input, applied just before the update that takes the game from tick `tick` to `tick + 1`. */
+typedef struct {
+	Uint32 tick;
+	Uint8 type;
+} ReplayEvent;
+
+
+/* A recorded game: the course it was played on, its inputs in tick order, and the tick and state checksum it ended on.
+ *
+ * On disk it is the magic and version, then seed, course length, final tick, checksum and event count as little-endian integers,
+ * then each event as the number of ticks since the previous one (a LEB128 varint) followed by its type byte. */
+typedef struct {
+	Uint64 seed;
+	int course_length;
+	Uint32 final_tick;
+	Uint32 checksum;
+	ReplayEvent* events;
+	int num_events;
+	int capacity;
+	int cursor;
+} Replay;
+
+
+void new_replay(Replay* replay, Uint64 seed, int course_length);
+void free_replay(Replay* replay);
+void replay_record(Replay* replay, Uint32 tick, int type);
+void replay_finish(Replay* replay, Uint32 final_tick, Uint32 checksum);
+void replay_apply(Replay* replay, Game* game);
+void replay_seek(Replay* replay, Uint32 tick);
+int save_replay(const Replay* replay, const char* path);
+int load_replay(Replay* replay, const char* path);
+
+#endif
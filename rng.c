@@ -0,0 +1,52 @@
+#include <time.h>
+#include "rng.h"
+
+
+/* Rotates `x` left by `k` bits. */
+static Uint32
+rotl(Uint32 x, int k) {
+	return (x << k) | (x >> (32 - k));
+}
+
+
+/* Fills the generator state from `seed` with splitmix64, so nearby seeds still give unrelated sequences. */
+void
+rng_seed(Rng* rng, Uint64 seed) {
+
+	int i;
+	Uint64 z;
+
+	for (i = 0; i < 4; i += 2) {
+		seed += 0x9E3779B97F4A7C15ULL;
+		z = seed;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z ^= z >> 31;
+		rng->s[i] = (Uint32)z;
+		rng->s[i + 1] = (Uint32)(z >> 32);
+	}
+}
+
+
+/* Returns the next 32 random bits. */
+Uint32
+rng_next(Rng* rng) {
+
+	Uint32 result = rotl(rng->s[1] * 5, 7) * 9, t = rng->s[1] << 9;
+
+	rng->s[2] ^= rng->s[0];
+	rng->s[3] ^= rng->s[1];
+	rng->s[1] ^= rng->s[2];
+	rng->s[0] ^= rng->s[3];
+	rng->s[2] ^= t;
+	rng->s[3] = rotl(rng->s[3], 11);
+
+	return result;
+}
+
+
+/* Returns a seed for runs where none was given. */
+Uint64
+rng_time_seed(void) {
+	return (Uint64)time(NULL);
+}
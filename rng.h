@@ -0,0 +1,25 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include "SDL.h"
+
+
+/* xoshiro128** generator. Every draw is plain 32-bit integer arithmetic, so a seed produces the same sequence on every platform
+ * and compiler. */
+typedef struct {
+	Uint32 s[4];
+} Rng;
+
+
+void rng_seed(Rng* rng, Uint64 seed);
+Uint32 rng_next(Rng* rng);
+Uint64 rng_time_seed(void);
+
+
+/* Returns a number in [0, n). */
+static inline int
+rng_range(Rng* rng, int n) {
+	return (int)(((Uint64)rng_next(rng) * (Uint32)n) >> 32);
+}
+
+#endif
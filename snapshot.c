@@ -0,0 +1,86 @@
+#include <assert.h>
+#include "snapshot.h"
+
+
+/* Saves the state of `game` on `course`. */
+void
+take_snapshot(Snapshot* snapshot, const Game* game, const Course* course) {
+	snapshot->game = *game;
+	save_course_cursor(course, &snapshot->course);
+}
+
+
+/* Puts `game` and `course` back as they were when `snapshot` was taken. `course` must be the course the snapshot was taken on. */
+void
+restore_snapshot(const Snapshot* snapshot, Game* game, Course* course) {
+	*game = snapshot->game;
+	restore_course_cursor(course, &snapshot->course);
+}
+
+
+/* Returns the arena space `new_snapshot_ring` needs for `capacity` snapshots. */
+size_t
+snapshot_ring_size(int capacity) {
+	return capacity * sizeof(Snapshot) + ARENA_ALIGNMENT;
+}
+
+
+/* Sets up an empty ring of `capacity` snapshots, a power of two, in `arena` (at least `snapshot_ring_size(capacity)` bytes free).
+ * Taking snapshots never allocates after this. */
+void
+new_snapshot_ring(SnapshotRing* ring, int capacity, Arena* arena) {
+	assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+	ring->snapshots = (Snapshot*)arena_alloc(arena, capacity * sizeof(Snapshot));
+	ring->capacity = capacity;
+	ring->mask = capacity - 1;
+	ring->first = 0;
+	ring->end = 0;
+}
+
+
+/* Adds a snapshot of `game` on `course` to the ring, overwriting the oldest one if the ring is full. Snapshots must be pushed in
+ * tick order. */
+void
+push_snapshot(SnapshotRing* ring, const Game* game, const Course* course) {
+	if (ring->end - ring->first == ring->capacity) {
+		ring->first++;
+	}
+	take_snapshot(&ring->snapshots[ring->end & ring->mask], game, course);
+	ring->end++;
+}
+
+
+/* Returns the newest held snapshot taken at or before `tick`, or NULL if every held snapshot is newer. */
+const Snapshot*
+find_snapshot(const SnapshotRing* ring, Uint32 tick) {
+
+	long low = ring->first, high = ring->end, middle;
+
+	// Snapshots are in tick order, so this finds the first one after `tick`; the one before it is the answer.
+	while (low < high) {
+		middle = low + (high - low) / 2;
+		if (ring->snapshots[middle & ring->mask].game.tick <= tick) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	return (low > ring->first) ? &ring->snapshots[(low - 1) & ring->mask] : NULL;
+}
+
+
+/* Rewinds `game` and `course` to the newest snapshot at or before `tick` and drops the snapshots after it, so play can go on from
+ * there. Returns FALSE, leaving everything as it was, if `tick` is older than every held snapshot. */
+int
+rewind_to(SnapshotRing* ring, Uint32 tick, Game* game, Course* course) {
+
+	const Snapshot* snapshot = find_snapshot(ring, tick);
+
+	if (snapshot == NULL) {
+		return FALSE;
+	}
+	restore_snapshot(snapshot, game, course);
+	ring->end = ring->first + (((snapshot - ring->snapshots) - ring->first) & ring->mask) + 1;
+	return TRUE;
+}
@@ -0,0 +1,39 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "SDL.h"
+#include "game.h"
+#include "arena.h"
+
+// A ring of one snapshot per tick holds the last ten seconds of play.
+#define SNAPSHOT_RING_SIZE 1024
+
+
+/* Everything needed to put a game back exactly as it was at one tick. Both parts are plain data, so a snapshot is taken and
+ * restored with two struct copies. */
+typedef struct {
+	Game game;
+	CourseCursor course;
+} Snapshot;
+
+
+/* The most recent snapshots, oldest overwritten first. Snapshot `i` (counting from the first one taken) lives in slot
+ * `i & mask`; snapshots `first` to `end - 1` are held. */
+typedef struct {
+	Snapshot* snapshots;
+	int capacity;
+	int mask;
+	long first;
+	long end;
+} SnapshotRing;
+
+
+void take_snapshot(Snapshot* snapshot, const Game* game, const Course* course);
+void restore_snapshot(const Snapshot* snapshot, Game* game, Course* course);
+size_t snapshot_ring_size(int capacity);
+void new_snapshot_ring(SnapshotRing* ring, int capacity, Arena* arena);
+void push_snapshot(SnapshotRing* ring, const Game* game, const Course* course);
+const Snapshot* find_snapshot(const SnapshotRing* ring, Uint32 tick);
+int rewind_to(SnapshotRing* ring, Uint32 tick, Game* game, Course* course);
+
+#endif
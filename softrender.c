@@ -0,0 +1,231 @@
+#include <string.h>
+#include <ctype.h>
+#include "softrender.h"
+#include "atlas.h"
+
+// The span fill is picked at compile time like the obstacle range kernel: AVX2 when the compiler targets it, SSE2 on any x86-64
+// build, scalar otherwise. Define SQUARE_JUMP_SCALAR to force the scalar fallback.
+#if !defined(SQUARE_JUMP_SCALAR) && defined(__AVX2__)
+#include <immintrin.h>
+#define FILL_KERNEL_NAME "avx2"
+#define FILL_LANES 8
+#elif !defined(SQUARE_JUMP_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define FILL_KERNEL_NAME "sse2"
+#define FILL_LANES 4
+#else
+#define FILL_KERNEL_NAME "scalar"
+#define FILL_LANES 1
+#endif
+
+
+static void fill_span(Uint32* row, int n, Uint32 colour);
+static int clip(const Canvas* canvas, const SDL_Rect* rect, SDL_Rect* out);
+static void blit_entry(Canvas* canvas, const AtlasEntry* entry, Uint32 colour, const SDL_Rect* rect);
+
+
+/* Returns the arena space `new_canvas` needs for a `width` x `height` canvas. */
+size_t
+canvas_size(int width, int height) {
+	return (size_t)width * height * sizeof(Uint32) + ARENA_ALIGNMENT;
+}
+
+
+/* Sets up a `width` x `height` canvas in `arena` (at least `canvas_size` bytes free). Its pixels are not cleared. */
+void
+new_canvas(Canvas* canvas, int width, int height, Arena* arena) {
+	canvas->pixels = (Uint32*)arena_alloc(arena, (size_t)width * height * sizeof(Uint32));
+	canvas->width = width;
+	canvas->height = height;
+}
+
+
+/* Packs an opaque `colour` into a canvas pixel. */
+Uint32
+canvas_colour(SDL_Colour colour) {
+
+	Uint8 bytes[4] = { colour.r, colour.g, colour.b, SDL_ALPHA_OPAQUE };
+	Uint32 pixel;
+
+	memcpy(&pixel, bytes, sizeof(pixel));
+	return pixel;
+}
+
+
+/* Returns the name of the span fill in use. */
+const char*
+canvas_kernel_name(void) {
+	return FILL_KERNEL_NAME;
+}
+
+
+/* Fills `count` rects with `colour`, clipped to the canvas. */
+void
+canvas_fill_rects(Canvas* canvas, Uint32 colour, const SDL_Rect* rects, int count) {
+
+	int i, y;
+	SDL_Rect area;
+
+	for (i = 0; i < count; i++) {
+		if (!clip(canvas, &rects[i], &area)) {
+			continue;
+		}
+		for (y = area.y; y < area.y + area.h; y++) {
+			fill_span(canvas->pixels + (size_t)y * canvas->width + area.x, area.w, colour);
+		}
+	}
+}
+
+
+/* Draws `text` baked in `font` into `rect`, scaled to it if `rect` has a size, or at its own size from `rect`'s top left corner
+ * if `rect->w` is 0. Text that wasn't baked as a whole is drawn a glyph at a time at its own size. Returns the width drawn; text
+ * with a character that wasn't baked (or any text, in a build without an atlas) is not drawn and returns 0. */
+int
+canvas_draw_text(Canvas* canvas, int font, const char* text, Uint32 colour, const SDL_Rect* rect) {
+
+	int i, width = 0;
+	char str[2] = { 0, 0 };
+	const AtlasEntry* entry = atlas_find(font, text);
+	const AtlasEntry* glyphs[ATLAS_TEXT_LENGTH];
+	SDL_Rect area = *rect;
+
+	if (entry != NULL) {
+		if (area.w == 0) {
+			area.w = entry->w;
+			area.h = entry->h;
+		}
+		blit_entry(canvas, entry, colour, &area);
+		return area.w;
+	}
+
+	for (i = 0; text[i] != '\0' && i < ATLAS_TEXT_LENGTH; i++) {
+		str[0] = (char)toupper((unsigned char)text[i]);
+		if ((glyphs[i] = atlas_find(font, str)) == NULL) {
+			return 0;
+		}
+	}
+	for (i = 0; text[i] != '\0' && i < ATLAS_TEXT_LENGTH; i++) {
+		area.x = rect->x + width;
+		area.w = glyphs[i]->w;
+		area.h = glyphs[i]->h;
+		blit_entry(canvas, glyphs[i], colour, &area);
+		width += glyphs[i]->w;
+	}
+	return width;
+}
+
+
+/* Draws in-game play the way `render_in_play` does, `alpha` (0 to 1) of the way from the previous tick to the current one, but
+ * into `canvas` with no renderer or display: background and floor, the obstacles on screen, the ghosts of `ghosts` (if not NULL),
+ * the player and the level HUD. */
+void
+soft_render(Canvas* canvas, const Palette* palette, Game* game, Course* course, GhostRace* ghosts, double alpha) {
+
+	int num_blocks, num_holes;
+	int camera = game->prev_camera_x + (game->camera_x - game->prev_camera_x) * alpha;
+	char str_level[2] = { 0, 0 };
+	const AtlasEntry* label;
+	const AtlasEntry* letter;
+	SDL_Rect player = game->player, blocks[MAX_VISIBLE_OBSTACLES], holes[MAX_VISIBLE_OBSTACLES];
+	SDL_Rect screen = { 0, 0, canvas->width, canvas->height };
+	SDL_Rect floor = { 0, INITIAL_FLOOR_Y, W_WIDTH, INITIAL_FLOOR_HEIGHT };
+	SDL_Rect hud;
+
+	player.x = (game->prev_player_x - game->prev_camera_x) + ((game->player.x - game->camera_x) -
+		(game->prev_player_x - game->prev_camera_x)) * alpha;
+	player.y = game->prev_player_y + (game->player.y - game->prev_player_y) * alpha;
+
+	num_blocks = visible_obstacles(game, course, camera, blocks, holes, &num_holes);
+
+	canvas_fill_rects(canvas, palette->background, &screen, 1);
+	canvas_fill_rects(canvas, palette->floor, &floor, 1);
+	canvas_fill_rects(canvas, palette->floor, blocks, num_blocks);
+	canvas_fill_rects(canvas, palette->background, holes, num_holes);
+	if (ghosts != NULL) {
+		canvas_fill_rects(canvas, palette->ghost, ghosts->rects, ghost_rects(ghosts, camera, alpha));
+	}
+	canvas_fill_rects(canvas, palette->player, &player, 1);
+
+	// The HUD is laid out as `prepare_hud` does it: the label is stretched over the width of the title in the level font, and the
+	// letter follows one letter's width after it.
+	str_level[0] = (char)game->level;
+	if ((label = atlas_find(FONT_LEVEL, TITLE)) != NULL && (letter = atlas_find(FONT_LEVEL, str_level)) != NULL) {
+		hud.x = 0;
+		hud.y = W_HEIGHT - label->h;
+		hud.w = label->w;
+		hud.h = label->h;
+		canvas_draw_text(canvas, FONT_LEVEL, LEVEL, palette->font, &hud);
+		hud.x = hud.w + 2 * letter->w;
+		hud.w = letter->w;
+		hud.h = letter->h;
+		blit_entry(canvas, letter, palette->font, &hud);
+	}
+}
+
+
+/* Fills `n` pixels from `row` with `colour`, a vector at a time. */
+static void
+fill_span(Uint32* row, int n, Uint32 colour) {
+
+	int i = 0;
+
+#if FILL_LANES == 8
+	__m256i v_colour = _mm256_set1_epi32((int)colour);
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_si256((__m256i*)(row + i), v_colour);
+	}
+#elif FILL_LANES == 4
+	__m128i v_colour = _mm_set1_epi32((int)colour);
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_si128((__m128i*)(row + i), v_colour);
+	}
+#endif
+	for (; i < n; i++) {
+		row[i] = colour;
+	}
+}
+
+
+/* Clips `rect` to the canvas into `out`. Returns FALSE if nothing of it is left. */
+static int
+clip(const Canvas* canvas, const SDL_Rect* rect, SDL_Rect* out) {
+
+	int x0 = (rect->x > 0) ? rect->x : 0, y0 = (rect->y > 0) ? rect->y : 0;
+	int x1 = (rect->x + rect->w < canvas->width) ? (rect->x + rect->w) : canvas->width;
+	int y1 = (rect->y + rect->h < canvas->height) ? (rect->y + rect->h) : canvas->height;
+
+	if (x0 >= x1 || y0 >= y1) {
+		return FALSE;
+	}
+	out->x = x0;
+	out->y = y0;
+	out->w = x1 - x0;
+	out->h = y1 - y0;
+	return TRUE;
+}
+
+
+/* Draws the set pixels of a baked atlas entry in `colour`, scaled (nearest neighbour) to `rect` and clipped to the canvas. */
+static void
+blit_entry(Canvas* canvas, const AtlasEntry* entry, Uint32 colour, const SDL_Rect* rect) {
+
+	int x, y, sx, sy, stride = atlas_width / 8;
+	const Uint8* bits;
+	Uint32* row;
+	SDL_Rect area;
+
+	if (rect->w <= 0 || rect->h <= 0 || !clip(canvas, rect, &area)) {
+		return;
+	}
+	for (y = area.y; y < area.y + area.h; y++) {
+		sy = entry->y + (y - rect->y) * entry->h / rect->h;
+		bits = atlas_bits + (size_t)sy * stride;
+		row = canvas->pixels + (size_t)y * canvas->width;
+		for (x = area.x; x < area.x + area.w; x++) {
+			sx = entry->x + (x - rect->x) * entry->w / rect->w;
+			if (bits[sx / 8] & (0x80 >> (sx % 8))) {
+				row[x] = colour;
+			}
+		}
+	}
+}
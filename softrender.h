@@ -0,0 +1,37 @@
+#ifndef SOFTRENDER_H
+#define SOFTRENDER_H
+
+#include "SDL.h"
+#include "game.h"
+#include "ghost.h"
+#include "arena.h"
+
+
+/* An image in memory, `width` x `height` pixels of four bytes each in R, G, B, A order (`SDL_PIXELFORMAT_RGBA32`), rows packed
+ * with no padding. */
+typedef struct {
+	Uint32* pixels;
+	int width;
+	int height;
+} Canvas;
+
+
+/* Colours of a frame, packed with `canvas_colour`. */
+typedef struct {
+	Uint32 background;
+	Uint32 floor;
+	Uint32 player;
+	Uint32 ghost;
+	Uint32 font;
+} Palette;
+
+
+size_t canvas_size(int width, int height);
+void new_canvas(Canvas* canvas, int width, int height, Arena* arena);
+Uint32 canvas_colour(SDL_Colour colour);
+void canvas_fill_rects(Canvas* canvas, Uint32 colour, const SDL_Rect* rects, int count);
+int canvas_draw_text(Canvas* canvas, int font, const char* text, Uint32 colour, const SDL_Rect* rect);
+void soft_render(Canvas* canvas, const Palette* palette, Game* game, Course* course, GhostRace* ghosts, double alpha);
+const char* canvas_kernel_name(void);
+
+#endif